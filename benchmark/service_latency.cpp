@@ -0,0 +1,415 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Round trip latency of the service path:
+// rmw_send_request -> rmw_take_request -> rmw_send_response -> rmw_take_response
+//
+// Usage: service_latency [--role both|server|client] [--sizes 16,1024,8192]
+//                        [--clients 1,2,3] [--calls 1000] [--domain 0] [--duration 60]
+//
+// With --role both, client and server share the context and calls take the
+// in-process shortcut. Run a server and a client process to measure the RTPS path,
+// the server process answers for --duration seconds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rcl_interfaces/msg/parameter_type.h>
+#include <rcl_interfaces/srv/get_parameters.h>
+#include <rcutils/allocator.h>
+#include <rosidl_runtime_c/string_functions.h>
+
+#include <rmw/error_handling.h>
+#include <rmw/rmw.h>
+
+#include <rmw_embeddedrtps/config.h>
+
+static const char service_name[] = "/service_latency_benchmark";
+
+// Room for the CDR encapsulation and fields around the payload of a request or response
+static const size_t cdr_overhead = 128;
+
+// Payloads must fit a received sample, and a sent one unless it can be heap allocated
+static const size_t max_input_payload =
+  RMW_ERTPS_MAX_INPUT_BUFFERS_PER_SAMPLE * (RMW_ERTPS_MAX_INPUT_BUFFER_SIZE - 8) - cdr_overhead;
+#ifdef RMW_ERTPS_ALLOW_DYNAMIC_ALLOCATIONS
+static const size_t max_payload = max_input_payload;
+#else
+static const size_t max_payload =
+  std::min(max_input_payload, static_cast<size_t>(RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE) - cdr_overhead);
+#endif  // RMW_ERTPS_ALLOW_DYNAMIC_ALLOCATIONS
+
+typedef struct benchmark_options_t
+{
+  std::string role;
+  std::vector<size_t> sizes;
+  std::vector<size_t> clients;
+  size_t calls;
+  size_t domain_id;
+  size_t duration;
+} benchmark_options_t;
+
+static std::vector<size_t> parse_list(
+  const char * list)
+{
+  std::vector<size_t> values;
+  std::string item;
+  for (const char * c = list; ; c++) {
+    if (*c == ',' || *c == '\0') {
+      if (!item.empty()) {
+        values.push_back(static_cast<size_t>(strtoul(item.c_str(), NULL, 10)));
+      }
+      item.clear();
+      if (*c == '\0') {
+        break;
+      }
+    } else {
+      item += *c;
+    }
+  }
+  return values;
+}
+
+static bool parse_options(
+  int argc,
+  char ** argv,
+  benchmark_options_t * options)
+{
+  options->role = "both";
+  // Default sizes above what the build can carry are replaced by the largest one
+  options->sizes.clear();
+  for (size_t size : {16, 1024, 8192}) {
+    size = std::min(size, max_payload);
+    if (options->sizes.empty() || options->sizes.back() != size) {
+      options->sizes.push_back(size);
+    }
+  }
+  options->clients = {1, 2, 3};
+  options->calls = 1000;
+  options->domain_id = 0;
+  options->duration = 60;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (0 == strcmp(argv[i], "--role")) {
+      options->role = argv[i + 1];
+    } else if (0 == strcmp(argv[i], "--sizes")) {
+      options->sizes = parse_list(argv[i + 1]);
+    } else if (0 == strcmp(argv[i], "--clients")) {
+      options->clients = parse_list(argv[i + 1]);
+    } else if (0 == strcmp(argv[i], "--calls")) {
+      options->calls = static_cast<size_t>(strtoul(argv[i + 1], NULL, 10));
+    } else if (0 == strcmp(argv[i], "--domain")) {
+      options->domain_id = static_cast<size_t>(strtoul(argv[i + 1], NULL, 10));
+    } else if (0 == strcmp(argv[i], "--duration")) {
+      options->duration = static_cast<size_t>(strtoul(argv[i + 1], NULL, 10));
+    } else {
+      return false;
+    }
+  }
+
+  for (size_t size : options->sizes) {
+    if (size > max_payload) {
+      fprintf(
+        stderr, "payload size %zu exceeds the %zu bytes this build can carry\n",
+        size, max_payload);
+      return false;
+    }
+  }
+
+  return (argc % 2) == 1 &&
+         !options->sizes.empty() && !options->clients.empty() &&
+         (options->role == "both" || options->role == "server" || options->role == "client");
+}
+
+static bool check(
+  rmw_ret_t ret,
+  const char * what)
+{
+  if (RMW_RET_OK != ret) {
+    fprintf(stderr, "%s failed: %s\n", what, rmw_get_error_string().str);
+    rmw_reset_error();
+    return false;
+  }
+  return true;
+}
+
+// Answers every request with a string as long as the requested name
+static void run_server(
+  rmw_context_t * context,
+  const rmw_service_t * service,
+  const std::atomic<bool> * done)
+{
+  rmw_wait_set_t * wait_set = rmw_create_wait_set(context, 1);
+  if (NULL == wait_set) {
+    fprintf(stderr, "server wait set creation failed\n");
+    return;
+  }
+
+  rcl_interfaces__srv__GetParameters_Request request;
+  rcl_interfaces__srv__GetParameters_Response response;
+  rcl_interfaces__srv__GetParameters_Request__init(&request);
+  rcl_interfaces__srv__GetParameters_Response__init(&response);
+  rcl_interfaces__msg__ParameterValue__Sequence__init(&response.values, 1);
+  response.values.data[0].type = rcl_interfaces__msg__ParameterType__PARAMETER_STRING;
+
+  const rmw_time_t timeout = {0, 100000000};
+  while (!done->load()) {
+    void * service_data = service->data;
+    rmw_services_t services = {1, &service_data};
+    if (RMW_RET_OK != rmw_wait(NULL, NULL, &services, NULL, NULL, wait_set, &timeout)) {
+      continue;
+    }
+
+    bool taken = true;
+    while (taken) {
+      rmw_service_info_t header;
+      if (!check(rmw_take_request(service, &header, &request, &taken), "rmw_take_request") ||
+        !taken)
+      {
+        break;
+      }
+
+      const rosidl_runtime_c__String * name = &request.names.data[0];
+      rosidl_runtime_c__String__assignn(
+        &response.values.data[0].string_value, name->data, name->size);
+      check(rmw_send_response(service, &header.request_id, &response), "rmw_send_response");
+    }
+  }
+
+  rcl_interfaces__srv__GetParameters_Response__fini(&response);
+  rcl_interfaces__srv__GetParameters_Request__fini(&request);
+  rmw_destroy_wait_set(wait_set);
+}
+
+// Sequential calls with a single outstanding request, round trip times in nanoseconds
+static void run_client(
+  rmw_context_t * context,
+  const rmw_client_t * client,
+  size_t payload_size,
+  size_t calls,
+  std::vector<int64_t> * latencies)
+{
+  rmw_wait_set_t * wait_set = rmw_create_wait_set(context, 1);
+  if (NULL == wait_set) {
+    fprintf(stderr, "client wait set creation failed\n");
+    return;
+  }
+
+  rcl_interfaces__srv__GetParameters_Request request;
+  rcl_interfaces__srv__GetParameters_Response response;
+  rcl_interfaces__srv__GetParameters_Request__init(&request);
+  rcl_interfaces__srv__GetParameters_Response__init(&response);
+  rosidl_runtime_c__String__Sequence__init(&request.names, 1);
+  std::string payload(payload_size, 'x');
+  rosidl_runtime_c__String__assignn(&request.names.data[0], payload.c_str(), payload.size());
+
+  const rmw_time_t timeout = {1, 0};
+  for (size_t i = 0; i < calls; i++) {
+    const auto start = std::chrono::steady_clock::now();
+
+    int64_t sequence_id;
+    if (!check(rmw_send_request(client, &request, &sequence_id), "rmw_send_request")) {
+      break;
+    }
+
+    bool taken = false;
+    while (!taken) {
+      void * client_data = client->data;
+      rmw_clients_t clients = {1, &client_data};
+      if (RMW_RET_OK != rmw_wait(NULL, NULL, NULL, &clients, NULL, wait_set, &timeout)) {
+        fprintf(stderr, "response to request %lld timed out\n", (long long)sequence_id);
+        break;
+      }
+
+      rmw_service_info_t header;
+      if (!check(
+          rmw_take_response(client, &header, &response, &taken), "rmw_take_response"))
+      {
+        break;
+      }
+      // Responses to calls that timed out earlier are skipped
+      taken = taken && header.request_id.sequence_number == sequence_id;
+    }
+    if (!taken) {
+      break;
+    }
+
+    latencies->push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+
+  rcl_interfaces__srv__GetParameters_Response__fini(&response);
+  rcl_interfaces__srv__GetParameters_Request__fini(&request);
+  rmw_destroy_wait_set(wait_set);
+}
+
+static double percentile_us(
+  const std::vector<int64_t> & sorted,
+  double percentile)
+{
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t index = static_cast<size_t>(percentile / 100.0 * static_cast<double>(sorted.size()));
+  index = std::min(index, sorted.size() - 1);
+  return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+static void run_clients(
+  rmw_context_t * context,
+  const std::vector<rmw_client_t *> & clients,
+  const benchmark_options_t & options)
+{
+  printf(
+    "%10s %8s %8s %12s %12s %12s %12s\n",
+    "size[B]", "clients", "calls", "p50[us]", "p99[us]", "p99.9[us]", "calls/s");
+
+  for (size_t payload_size : options.sizes) {
+    for (size_t client_count : options.clients) {
+      client_count = std::min(std::max(client_count, static_cast<size_t>(1)), clients.size());
+
+      std::vector<std::vector<int64_t>> latencies(client_count);
+      std::vector<std::thread> threads;
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < client_count; i++) {
+        latencies[i].reserve(options.calls);
+        threads.emplace_back(
+          run_client, context, clients[i], payload_size, options.calls, &latencies[i]);
+      }
+      for (std::thread & thread : threads) {
+        thread.join();
+      }
+      const double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+      std::vector<int64_t> all;
+      for (const std::vector<int64_t> & client_latencies : latencies) {
+        all.insert(all.end(), client_latencies.begin(), client_latencies.end());
+      }
+      std::sort(all.begin(), all.end());
+
+      printf(
+        "%10zu %8zu %8zu %12.1f %12.1f %12.1f %12.1f\n",
+        payload_size, client_count, all.size(),
+        percentile_us(all, 50.0), percentile_us(all, 99.0), percentile_us(all, 99.9),
+        elapsed > 0.0 ? static_cast<double>(all.size()) / elapsed : 0.0);
+    }
+  }
+}
+
+int main(
+  int argc,
+  char ** argv)
+{
+  benchmark_options_t options;
+  if (!parse_options(argc, argv, &options)) {
+    fprintf(
+      stderr,
+      "usage: %s [--role both|server|client] [--sizes 16,1024] [--clients 1,2] "
+      "[--calls 1000] [--domain 0] [--duration 60]\n", argv[0]);
+    return 1;
+  }
+
+  rmw_init_options_t init_options = rmw_get_zero_initialized_init_options();
+  rmw_context_t context = rmw_get_zero_initialized_context();
+  if (!check(
+      rmw_init_options_init(&init_options, rcutils_get_default_allocator()),
+      "rmw_init_options_init"))
+  {
+    return 1;
+  }
+  init_options.domain_id = options.domain_id;
+  if (!check(rmw_init(&init_options, &context), "rmw_init")) {
+    return 1;
+  }
+
+  rmw_node_t * node = rmw_create_node(&context, "service_latency", "/");
+  if (NULL == node) {
+    fprintf(stderr, "node creation failed: %s\n", rmw_get_error_string().str);
+    return 1;
+  }
+
+  const rosidl_service_type_support_t * type_support =
+    ROSIDL_GET_SRV_TYPE_SUPPORT(rcl_interfaces, srv, GetParameters);
+  const rmw_qos_profile_t qos = rmw_qos_profile_services_default;
+
+  std::atomic<bool> done{false};
+  std::thread server_thread;
+  if (options.role != "client") {
+    rmw_service_t * service = rmw_create_service(node, type_support, service_name, &qos);
+    if (NULL == service) {
+      fprintf(stderr, "service creation failed: %s\n", rmw_get_error_string().str);
+      return 1;
+    }
+    server_thread = std::thread(run_server, &context, service, &done);
+  }
+
+  if (options.role == "server") {
+    // Nothing else ends the serve loop in a server only process
+    std::this_thread::sleep_for(std::chrono::seconds(options.duration));
+    done.store(true);
+  } else {
+    // Every client thread needs a wait set, one is left for a server in the same process
+    const size_t server_wait_sets = (options.role == "both") ? 1 : 0;
+    if (RMW_ERTPS_MAX_WAIT_SETS <= server_wait_sets) {
+      fprintf(stderr, "no wait set left for clients, raise RMW_ERTPS_MAX_WAIT_SETS\n");
+      done.store(true);
+      if (server_thread.joinable()) {
+        server_thread.join();
+      }
+      return 1;
+    }
+    size_t max_clients = *std::max_element(options.clients.begin(), options.clients.end());
+    max_clients = std::min(
+      max_clients, static_cast<size_t>(RMW_ERTPS_MAX_WAIT_SETS) - server_wait_sets);
+    max_clients = std::max(max_clients, static_cast<size_t>(1));
+
+    std::vector<rmw_client_t *> clients;
+    for (size_t i = 0; i < max_clients; i++) {
+      rmw_client_t * client = rmw_create_client(node, type_support, service_name, &qos);
+      if (NULL == client) {
+        fprintf(stderr, "client creation failed: %s\n", rmw_get_error_string().str);
+        return 1;
+      }
+      clients.push_back(client);
+    }
+
+    // Wait for discovery before the first call
+    bool is_available = false;
+    while (!is_available) {
+      check(
+        rmw_service_server_is_available(node, clients[0], &is_available),
+        "rmw_service_server_is_available");
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    run_clients(&context, clients, options);
+    done.store(true);
+  }
+
+  if (server_thread.joinable()) {
+    server_thread.join();
+  }
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_EMBEDDEDRTPS__BATCHING_H_
+#define RMW_EMBEDDEDRTPS__BATCHING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <rmw/types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Enables or disables sample batching on a context.
+/**
+ * While enabled, samples published on any publisher of the context are held back and
+ * handed to embeddedRTPS together when the batch reaches `max_bytes`, when its oldest sample
+ * is older than `max_latency`, on rmw_embeddedrtps_flush_batch() or when rmw_wait() is called.
+ * Disabling batching flushes any pending sample.
+ *
+ * Requires the library to be built with RMW_ERTPS_BATCHING.
+ *
+ * \param[in] context initialized rmw context
+ * \param[in] enable whether batching should be used
+ * \param[in] max_bytes byte budget of a batch, bounded by RMW_ERTPS_MAX_BATCH_SIZE
+ * \param[in] max_latency maximum time a sample may be held back
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if context is invalid, or
+ * \return RMW_RET_UNSUPPORTED if batching is not compiled in.
+ */
+rmw_ret_t
+rmw_embeddedrtps_set_batching(
+  rmw_context_t * context,
+  bool enable,
+  size_t max_bytes,
+  rmw_time_t max_latency);
+
+/// Sends every sample held back in the batch of a context.
+/**
+ * Meant to be called by executors at the end of each cycle.
+ *
+ * \param[in] context initialized rmw context
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if context is invalid, or
+ * \return RMW_RET_UNSUPPORTED if batching is not compiled in.
+ */
+rmw_ret_t
+rmw_embeddedrtps_flush_batch(
+  rmw_context_t * context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_EMBEDDEDRTPS__BATCHING_H_
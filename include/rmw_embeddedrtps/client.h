@@ -0,0 +1,101 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_EMBEDDEDRTPS__CLIENT_H_
+#define RMW_EMBEDDEDRTPS__CLIENT_H_
+
+#include <stddef.h>
+
+#include <rcutils/time.h>
+#include <rmw/types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Round trip statistics of the requests completed by a client.
+typedef struct rmw_embeddedrtps_client_latency_t
+{
+  /// Number of responses taken for a known request
+  size_t count;
+  /// Requests given up because no response was taken within the client lifespan
+  size_t abandoned;
+  /// Round trip times in nanoseconds, 0 while count is 0
+  rcutils_duration_value_t last;
+  rcutils_duration_value_t min;
+  rcutils_duration_value_t max;
+  rcutils_duration_value_t mean;
+} rmw_embeddedrtps_client_latency_t;
+
+/// Retrieves the request round trip statistics of a client.
+/**
+ * Latency is measured from rmw_send_request() to rmw_take_response() of the matching
+ * response, so it includes the time the response waited to be taken.
+ *
+ * \param[in] client client handle
+ * \param[out] latency statistics
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if any argument is invalid.
+ */
+rmw_ret_t
+rmw_embeddedrtps_client_get_latency(
+  const rmw_client_t * client,
+  rmw_embeddedrtps_client_latency_t * latency);
+
+/// Sets the maximum age of the responses buffered for a client.
+/**
+ * Responses older than `lifespan` when taken, or when the input buffer pool runs out, are
+ * discarded. The initial value is the lifespan of the client QoS profile. A zero or infinite
+ * lifespan disables the limit.
+ *
+ * \param[in] client client handle
+ * \param[in] lifespan maximum age of buffered responses
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if client is invalid.
+ */
+rmw_ret_t
+rmw_embeddedrtps_client_set_lifespan(
+  const rmw_client_t * client,
+  rmw_time_t lifespan);
+
+/// Takes the response to a given request of a client.
+/**
+ * Responses to other requests stay queued for rmw_take_response() or later calls, so
+ * several requests can be in flight at once, up to RMW_ERTPS_MAX_PENDING_REQUESTS,
+ * and be taken in any order. Beyond that rmw_send_request() fails until a response is
+ * taken or, with a lifespan set, an older request expires.
+ *
+ * \param[in] client client handle
+ * \param[in] sequence_id sequence id returned by rmw_send_request()
+ * \param[out] request_header header of the taken response
+ * \param[out] ros_response taken response
+ * \param[out] taken true if the response had arrived and was taken
+ * \return RMW_RET_OK if successful, even if nothing was taken, or
+ * \return RMW_RET_INVALID_ARGUMENT if any argument is invalid, or
+ * \return RMW_RET_ERROR if the response cannot be deserialized.
+ */
+rmw_ret_t
+rmw_embeddedrtps_take_response_by_sequence_id(
+  const rmw_client_t * client,
+  int64_t sequence_id,
+  rmw_service_info_t * request_header,
+  void * ros_response,
+  bool * taken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_EMBEDDEDRTPS__CLIENT_H_
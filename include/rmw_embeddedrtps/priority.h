@@ -0,0 +1,118 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_EMBEDDEDRTPS__PRIORITY_H_
+#define RMW_EMBEDDEDRTPS__PRIORITY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rcutils/time.h>
+#include <rmw/types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Implementation specific subscription options.
+/**
+ * Passed through the `rmw_specific_subscription_payload` field of rmw_subscription_options_t.
+ */
+typedef struct rmw_embeddedrtps_subscription_options_t
+{
+  /// Readiness priority, higher values are reported first
+  uint8_t priority;
+} rmw_embeddedrtps_subscription_options_t;
+
+typedef enum rmw_embeddedrtps_entity_kind_t
+{
+  RMW_EMBEDDEDRTPS_ENTITY_SUBSCRIPTION,
+  RMW_EMBEDDEDRTPS_ENTITY_SERVICE,
+  RMW_EMBEDDEDRTPS_ENTITY_CLIENT
+} rmw_embeddedrtps_entity_kind_t;
+
+/// Entity with buffered data, as reported by rmw_embeddedrtps_get_ready_entities().
+typedef struct rmw_embeddedrtps_ready_entity_t
+{
+  rmw_embeddedrtps_entity_kind_t kind;
+  /// rmw_subscription_t, rmw_service_t or rmw_client_t handle, depending on kind
+  const void * handle;
+  uint8_t priority;
+  /// Steady clock arrival time of the oldest buffered sample
+  rcutils_time_point_value_t oldest_sample_time;
+} rmw_embeddedrtps_ready_entity_t;
+
+/// Sets the readiness priority of a subscription, 0 by default.
+/**
+ * \param[in] subscription subscription handle
+ * \param[in] priority higher values are reported first
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if subscription is invalid.
+ */
+rmw_ret_t
+rmw_embeddedrtps_subscription_set_priority(
+  const rmw_subscription_t * subscription,
+  uint8_t priority);
+
+/// Sets the readiness priority of a service, 0 by default.
+/**
+ * \param[in] service service handle
+ * \param[in] priority higher values are reported first
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if service is invalid.
+ */
+rmw_ret_t
+rmw_embeddedrtps_service_set_priority(
+  const rmw_service_t * service,
+  uint8_t priority);
+
+/// Sets the readiness priority of a client, 0 by default.
+/**
+ * \param[in] client client handle
+ * \param[in] priority higher values are reported first
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if client is invalid.
+ */
+rmw_ret_t
+rmw_embeddedrtps_client_set_priority(
+  const rmw_client_t * client,
+  uint8_t priority);
+
+/// Lists the entities of a wait set that hold buffered data, most urgent first.
+/**
+ * Entities are ordered by descending priority, then by the age of their oldest sample.
+ * Meant to be called after rmw_wait() on the same wait set, only entities passed to the last
+ * rmw_wait() call are considered. When more entities are ready than fit in `entities`, the
+ * most urgent ones are returned.
+ *
+ * \param[in] wait_set wait set handle
+ * \param[out] entities array receiving the ready entities
+ * \param[in] capacity size of `entities`
+ * \param[out] count number of entries written
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if any argument is invalid.
+ */
+rmw_ret_t
+rmw_embeddedrtps_get_ready_entities(
+  const rmw_wait_set_t * wait_set,
+  rmw_embeddedrtps_ready_entity_t * entities,
+  size_t capacity,
+  size_t * count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_EMBEDDEDRTPS__PRIORITY_H_
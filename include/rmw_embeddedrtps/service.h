@@ -0,0 +1,77 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_EMBEDDEDRTPS__SERVICE_H_
+#define RMW_EMBEDDEDRTPS__SERVICE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rmw/types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Sends a service response serialized into a caller provided buffer.
+/**
+ * rmw_take_request() and rmw_send_response() can be called from several threads on the same
+ * service, but rmw_send_response() serializes into a single buffer shared by every service, so
+ * responses are sent one at a time. Worker threads owning a buffer each can use this function
+ * instead to answer requests fully in parallel. The buffer is released before waking a client
+ * of the same context, so its listener may send responses itself.
+ *
+ * Responses not fitting in `buffer` are handled as with rmw_send_response(): serialized into
+ * a buffer allocated with the RMW allocator if built with RMW_ERTPS_ALLOW_DYNAMIC_ALLOCATIONS,
+ * rejected otherwise.
+ *
+ * \param[in] service service handle
+ * \param[in] request_header header of the request being answered
+ * \param[in] ros_response response to send
+ * \param[in] buffer serialization buffer, only used during the call
+ * \param[in] buffer_size size of `buffer`, at least 4 bytes
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if any argument is invalid, or
+ * \return RMW_RET_ERROR if the response cannot be serialized or sent.
+ */
+rmw_ret_t
+rmw_embeddedrtps_send_response_with_buffer(
+  const rmw_service_t * service,
+  rmw_request_id_t * request_header,
+  void * ros_response,
+  uint8_t * buffer,
+  size_t buffer_size);
+
+/// Sets the maximum age of the requests buffered for a service.
+/**
+ * Requests older than `lifespan` when taken, or when the input buffer pool runs out, are
+ * discarded without being answered. The initial value is the lifespan of the service QoS
+ * profile. A zero or infinite lifespan disables the limit.
+ *
+ * \param[in] service service handle
+ * \param[in] lifespan maximum age of buffered requests
+ * \return RMW_RET_OK if successful, or
+ * \return RMW_RET_INVALID_ARGUMENT if service is invalid.
+ */
+rmw_ret_t
+rmw_embeddedrtps_service_set_lifespan(
+  const rmw_service_t * service,
+  rmw_time_t lifespan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_EMBEDDEDRTPS__SERVICE_H_
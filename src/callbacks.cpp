@@ -13,8 +13,276 @@
 // limitations under the License.
 
 #include "./callbacks.hpp"
+#include "./rmw_event.hpp"
+#include "./rmw_pending_requests.hpp"
+#include "./rmw_wait_set.hpp"
 #include "./types.hpp"
 
+// Readers shared by several entities hand each sample to one of them
+template<typename T>
+static bool owns_sample(
+  const T * element,
+  const rtps::ReaderCacheChange & cacheChange)
+{
+  (void)element;
+  (void)cacheChange;
+  return true;
+}
+
+// Clients of the same reply topic share a reader, replies go to the client whose request
+// writer sent the request. Replies to clients of other participants are dropped.
+template<>
+bool owns_sample<rmw_ertps_client_t>(
+  const rmw_ertps_client_t * element,
+  const rtps::ReaderCacheChange & cacheChange)
+{
+  return cacheChange.relatedWriterGuid == element->writer->m_attributes.endpointGuid;
+}
+
+// The shared parameter service endpoints take no requests over RTPS, which could not tell
+// the services apart. Only clients of the same context call them, see rmw_shared_services.hpp
+template<>
+bool owns_sample<rmw_ertps_service_t>(
+  const rmw_ertps_service_t * element,
+  const rtps::ReaderCacheChange & cacheChange)
+{
+  (void)cacheChange;
+  return 0 == element->shared_index;
+}
+
+// Early filtering of received samples, before they take an input buffer
+template<typename T>
+static bool accept_sample(
+  const T * element,
+  const rtps::ReaderCacheChange & cacheChange)
+{
+  (void)element;
+  (void)cacheChange;
+  return true;
+}
+
+// Whether a writer of the own participant already handed its samples over to the
+// subscription through rmw_ertps_deliver_to_local_subscriptions
+static bool is_delivered_locally(
+  const rmw_ertps_subscription_t * subscription,
+  const rtps::Guid_t & writer_guid)
+{
+  size_t index = static_cast<size_t>(subscription - custom_subscriptions);
+  if (index >= RMW_ERTPS_MAX_SUBSCRIPTIONS) {
+    // Out of the static pool, only reachable through RTPS
+    return false;
+  }
+
+  rtps::Lock lock{publisher_memory.memory_mutex};
+
+  rmw_ertps_mempool_item_t * item = publisher_memory.allocateditems;
+  while (item != NULL) {
+    const rmw_ertps_publisher_t * publisher =
+      reinterpret_cast<const rmw_ertps_publisher_t *>(item->data);
+    if (NULL != publisher->rmw_handle &&
+      publisher->rmw_handle->data == publisher &&
+      NULL != publisher->writer &&
+      publisher->writer->m_attributes.endpointGuid == writer_guid)
+    {
+      return RMW_ERTPS_BITMAP_IS_SET(publisher->local_subscriptions, index);
+    }
+    item = item->next;
+  }
+  return false;
+}
+
+// Discards the RTPS copy of samples already delivered locally, and every sample of
+// the own participant when the subscription ignores local publications
+template<>
+bool accept_sample<rmw_ertps_subscription_t>(
+  const rmw_ertps_subscription_t * element,
+  const rtps::ReaderCacheChange & cacheChange)
+{
+  if (cacheChange.writerGuid.prefix != element->owner_node->context->participant->m_guidPrefix) {
+    return true;
+  }
+  return !element->ignore_local_publications &&
+         !is_delivered_locally(element, cacheChange.writerGuid);
+}
+
+// Whether a client of the own participant already handed its requests over to the
+// service through rmw_ertps_deliver_to_local_service
+static bool is_delivered_locally(
+  const rmw_ertps_service_t * service,
+  const rtps::Guid_t & writer_guid)
+{
+  rtps::Lock lock{client_memory.memory_mutex};
+
+  rmw_ertps_mempool_item_t * item = client_memory.allocateditems;
+  while (item != NULL) {
+    const rmw_ertps_client_t * client = reinterpret_cast<const rmw_ertps_client_t *>(item->data);
+    if (NULL != client->rmw_handle &&
+      client->rmw_handle->data == client &&
+      NULL != client->writer &&
+      client->writer->m_attributes.endpointGuid == writer_guid)
+    {
+      return client->local_service == service;
+    }
+    item = item->next;
+  }
+  return false;
+}
+
+// Discards the RTPS copy of requests already delivered locally
+template<>
+bool accept_sample<rmw_ertps_service_t>(
+  const rmw_ertps_service_t * element,
+  const rtps::ReaderCacheChange & cacheChange)
+{
+  return cacheChange.writerGuid.prefix !=
+         element->owner_node->context->participant->m_guidPrefix ||
+         !is_delivered_locally(element, cacheChange.writerGuid);
+}
+
+// Responses to requests this client is not waiting for are stale or unknown
+template<>
+bool accept_sample<rmw_ertps_client_t>(
+  const rmw_ertps_client_t * element,
+  const rtps::ReaderCacheChange & cacheChange)
+{
+  // Waits for a request still being sent to be recorded
+  rtps::Lock request_lock{const_cast<rmw_ertps_client_t *>(element)->request_mutex};
+  rtps::Lock lock{element->owner_node->context->ready_mutex};
+  return rmw_ertps_pending_request_is_known(
+    element, rmw_ertps_sequence_id(cacheChange.relatedSequenceNumber));
+}
+
+// Only subscriptions have QoS events, services and clients ignore these
+template<typename T>
+static void sample_stored(
+  T * element,
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
+  (void)element;
+  (void)static_buffer_item;
+}
+
+template<>
+void sample_stored<rmw_ertps_subscription_t>(
+  rmw_ertps_subscription_t * element,
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
+  rmw_ertps_events_sample_stored(
+    element,
+    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data)->arrival_time);
+}
+
+template<typename T>
+static void sample_notified(
+  T * element)
+{
+  (void)element;
+}
+
+template<>
+void sample_notified<rmw_ertps_subscription_t>(
+  rmw_ertps_subscription_t * element)
+{
+  rmw_ertps_events_sample_notified(element);
+}
+
+template<typename T>
+static void sample_lost(
+  T * element)
+{
+  (void)element;
+}
+
+template<>
+void sample_lost<rmw_ertps_subscription_t>(
+  rmw_ertps_subscription_t * element)
+{
+  rmw_ertps_events_sample_lost(element);
+}
+
+// Buffers a sample for the entity and returns its listener, false if it was rejected
+template<typename T>
+static bool buffer_sample(
+  T * element,
+  const uint8_t * data,
+  size_t length,
+  const rtps::Guid_t & writer_guid,
+  const rtps::SequenceNumber_t & sequence_number,
+  const rtps::Guid_t & related_writer_guid,
+  const rtps::SequenceNumber_t & related_sequence_number,
+  rmw_event_callback_t * on_new_data,
+  const void ** on_new_data_user_data)
+{
+  bool stored = false;
+  {
+    rmw_context_impl_t * context = element->owner_node->context;
+    rtps::Lock lock{context->ready_mutex};
+    rmw_ertps_mempool_item_t * static_buffer_item = rmw_ertps_store_static_input_buffer(
+      data, length,
+      writer_guid, sequence_number,
+      related_writer_guid, related_sequence_number,
+      reinterpret_cast<void *>(element));
+    if (NULL == static_buffer_item && rmw_ertps_expire_samples(context)) {
+      // Expired requests and responses made room
+      static_buffer_item = rmw_ertps_store_static_input_buffer(
+        data, length,
+        writer_guid, sequence_number,
+        related_writer_guid, related_sequence_number,
+        reinterpret_cast<void *>(element));
+    }
+    if (NULL != static_buffer_item) {
+      rmw_ertps_ready_push(element, static_buffer_item);
+      sample_stored(element, static_buffer_item);
+      *on_new_data = element->on_new_data;
+      *on_new_data_user_data = element->on_new_data_user_data;
+      stored = true;
+    }
+  }
+
+  if (!stored) {
+    // Input buffer pool exhausted, the sample is rejected
+    sample_lost(element);
+  }
+  return stored;
+}
+
+// Wakes the wait sets and listener of an entity with a new sample buffered
+template<typename T>
+static void notify_sample(
+  T * element,
+  rmw_event_callback_t on_new_data,
+  const void * on_new_data_user_data)
+{
+  rmw_ertps_wait_set_notify(&element->wait_set_mask);
+  if (NULL != on_new_data) {
+    on_new_data(on_new_data_user_data, 1);
+  }
+  sample_notified(element);
+}
+
+// Buffers a sample for the entity, then wakes its wait sets and listener
+template<typename T>
+static void store_sample(
+  T * element,
+  const uint8_t * data,
+  size_t length,
+  const rtps::Guid_t & writer_guid,
+  const rtps::SequenceNumber_t & sequence_number,
+  const rtps::Guid_t & related_writer_guid,
+  const rtps::SequenceNumber_t & related_sequence_number)
+{
+  rmw_event_callback_t on_new_data = NULL;
+  const void * on_new_data_user_data = NULL;
+  if (buffer_sample(
+      element, data, length,
+      writer_guid, sequence_number,
+      related_writer_guid, related_sequence_number,
+      &on_new_data, &on_new_data_user_data))
+  {
+    notify_sample(element, on_new_data, on_new_data_user_data);
+  }
+}
+
 template<typename T>
 void inner_callback(
   void * callee, const rtps::ReaderCacheChange & cacheChange,
@@ -25,26 +293,16 @@ void inner_callback(
   while (item != NULL) {
     T * element = reinterpret_cast<T *>(item->data);
 
-    if (element->reader == reader) {
-      rmw_ertps_mempool_item_t * memory_node = get_memory(&static_buffer_memory);
-      if (!memory_node) {
-        RMW_SET_ERROR_MSG("Not available static buffer memory node");
-        return;
-      }
-
-      rmw_ertps_static_input_buffer_t * static_buffer =
-        reinterpret_cast<rmw_ertps_static_input_buffer_t *>(memory_node->data);
-      static_buffer->owner = reinterpret_cast<void *>(element);
-      static_buffer->length = cacheChange.getDataSize();
-      static_buffer->writer_guid = cacheChange.writerGuid;
-      static_buffer->sequence_number = cacheChange.sn;
-      static_buffer->related_writer_guid = cacheChange.relatedWriterGuid;
-      static_buffer->related_sequence_number = cacheChange.relatedSequenceNumber;
-      if (!cacheChange.copyInto(static_buffer->buffer, RMW_ERTPS_MAX_INPUT_BUFFER_SIZE)) {
-        put_memory(&static_buffer_memory, memory_node);
-      } else {
-        extern sys_sem_t rmw_wait_sem;
-        sys_sem_signal(&rmw_wait_sem);
+    if (element->reader == reader && owns_sample(element, cacheChange)) {
+      if (accept_sample(element, cacheChange)) {
+        store_sample(
+          element,
+          cacheChange.getData(),
+          cacheChange.getDataSize(),
+          cacheChange.writerGuid,
+          cacheChange.sn,
+          cacheChange.relatedWriterGuid,
+          cacheChange.relatedSequenceNumber);
       }
 
       return;
@@ -76,3 +334,125 @@ void generic_callback<rmw_ertps_client_t>(
 {
   inner_callback<rmw_ertps_client_t>(callee, cacheChange, &client_memory);
 }
+
+void rmw_ertps_deliver_to_local_subscriptions(
+  const rmw_ertps_publisher_t * publisher,
+  const uint8_t * data,
+  size_t length,
+  const rtps::SequenceNumber_t & sequence_number)
+{
+  static const rtps::Guid_t unrelated_writer_guid{};
+  static const rtps::SequenceNumber_t unrelated_sequence_number{};
+
+  for (size_t i = 0; i < RMW_ERTPS_MAX_SUBSCRIPTIONS; i++) {
+    if (!RMW_ERTPS_BITMAP_IS_SET(publisher->local_subscriptions, i)) {
+      continue;
+    }
+
+    store_sample(
+      &custom_subscriptions[i],
+      data, length,
+      publisher->writer->m_attributes.endpointGuid,
+      sequence_number,
+      unrelated_writer_guid,
+      unrelated_sequence_number);
+  }
+}
+
+void rmw_ertps_deliver_to_local_service(
+  const rmw_ertps_client_t * client,
+  const uint8_t * data,
+  size_t length,
+  const rtps::SequenceNumber_t & sequence_number)
+{
+  static const rtps::Guid_t unrelated_writer_guid{};
+  static const rtps::SequenceNumber_t unrelated_sequence_number{};
+
+  if (NULL == client->local_service) {
+    return;
+  }
+
+  store_sample(
+    client->local_service,
+    data, length,
+    client->writer->m_attributes.endpointGuid,
+    sequence_number,
+    unrelated_writer_guid,
+    unrelated_sequence_number);
+}
+
+bool rmw_ertps_deliver_to_local_client(
+  const rmw_ertps_service_t * service,
+  const uint8_t * data,
+  size_t length,
+  const rtps::Guid_t & related_writer_guid,
+  const rtps::SequenceNumber_t & related_sequence_number,
+  rmw_ertps_local_response_t * local_response)
+{
+  static const rtps::SequenceNumber_t unrelated_sequence_number{};
+
+  local_response->client = NULL;
+
+  rmw_context_impl_t * context = service->owner_node->context;
+  if (related_writer_guid.prefix != context->participant->m_guidPrefix) {
+    return false;
+  }
+
+  rmw_ertps_client_t * client = NULL;
+  {
+    rtps::Lock lock{client_memory.memory_mutex};
+    rmw_ertps_mempool_item_t * item = client_memory.allocateditems;
+    while (item != NULL) {
+      rmw_ertps_client_t * candidate = reinterpret_cast<rmw_ertps_client_t *>(item->data);
+      if (candidate->local_service == service &&
+        candidate->writer->m_attributes.endpointGuid == related_writer_guid)
+      {
+        client = candidate;
+        break;
+      }
+      item = item->next;
+    }
+  }
+
+  if (NULL == client) {
+    // Not linked to this service, the request came through RTPS
+    return false;
+  }
+
+  bool known;
+  {
+    rtps::Lock lock{context->ready_mutex};
+    known = rmw_ertps_pending_request_is_known(
+      client, rmw_ertps_sequence_id(related_sequence_number));
+  }
+
+  if (!known) {
+    return false;
+  }
+
+  if (buffer_sample(
+      client,
+      data, length,
+      service->writer->m_attributes.endpointGuid,
+      unrelated_sequence_number,
+      related_writer_guid,
+      related_sequence_number,
+      &local_response->on_new_data,
+      &local_response->on_new_data_user_data))
+  {
+    local_response->client = client;
+  }
+
+  return true;
+}
+
+void rmw_ertps_notify_local_client(
+  const rmw_ertps_local_response_t * local_response)
+{
+  if (NULL != local_response->client) {
+    notify_sample(
+      local_response->client,
+      local_response->on_new_data,
+      local_response->on_new_data_user_data);
+  }
+}
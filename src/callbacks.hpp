@@ -17,7 +17,43 @@
 
 #include <rtps/rtps.h>
 
+#include "./types.hpp"
+
 template<typename T>
 void generic_callback(void * callee, const rtps::ReaderCacheChange & cacheChange);
 
+void rmw_ertps_deliver_to_local_subscriptions(
+  const rmw_ertps_publisher_t * publisher,
+  const uint8_t * data,
+  size_t length,
+  const rtps::SequenceNumber_t & sequence_number);
+
+void rmw_ertps_deliver_to_local_service(
+  const rmw_ertps_client_t * client,
+  const uint8_t * data,
+  size_t length,
+  const rtps::SequenceNumber_t & sequence_number);
+
+// Wake-up owed to a client of the same context once a response is buffered for it
+typedef struct rmw_ertps_local_response_t
+{
+  rmw_ertps_client_t * client;
+  rmw_event_callback_t on_new_data;
+  const void * on_new_data_user_data;
+} rmw_ertps_local_response_t;
+
+// Returns true if the response was handed to a client of the same context waiting
+// for it, otherwise it must be sent through RTPS. The client is only woken by
+// rmw_ertps_notify_local_client, as its listener may send a response itself.
+bool rmw_ertps_deliver_to_local_client(
+  const rmw_ertps_service_t * service,
+  const uint8_t * data,
+  size_t length,
+  const rtps::Guid_t & related_writer_guid,
+  const rtps::SequenceNumber_t & related_sequence_number,
+  rmw_ertps_local_response_t * local_response);
+
+void rmw_ertps_notify_local_client(
+  const rmw_ertps_local_response_t * local_response);
+
 #endif  // CALLBACKS_HPP_
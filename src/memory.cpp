@@ -16,6 +16,7 @@
 
 #include <string.h>
 #include <rmw/allocators.h>
+#include <rmw_embeddedrtps/config.h>
 
 
 static bool has_memory(
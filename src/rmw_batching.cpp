@@ -0,0 +1,169 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include <rcutils/time.h>
+
+#include <rmw/error_handling.h>
+#include <rmw/time.h>
+
+#include <rmw_embeddedrtps/batching.h>
+
+#include "./rmw_batching.hpp"
+
+#ifdef RMW_ERTPS_BATCHING
+static void flush_batch(
+  rmw_ertps_batch_t * batch)
+{
+  for (size_t i = 0; i < batch->change_count; i++) {
+    batch->changes[i].writer->newChange(
+      rtps::ChangeKind_t::ALIVE,
+      &batch->buffer[batch->changes[i].offset],
+      static_cast<rtps::DataSize_t>(batch->changes[i].length));
+  }
+
+  batch->change_count = 0;
+  batch->used = 0;
+}
+#endif  // RMW_ERTPS_BATCHING
+
+bool rmw_ertps_batch_init(
+  rmw_context_impl_t * context)
+{
+#ifdef RMW_ERTPS_BATCHING
+  if (ERR_OK != sys_mutex_new(&context->batch.mutex)) {
+    return false;
+  }
+  context->batch.enabled = false;
+  context->batch.max_bytes = RMW_ERTPS_MAX_BATCH_SIZE;
+  context->batch.max_latency = 0;
+  context->batch.first_change_timestamp = 0;
+  context->batch.used = 0;
+  context->batch.change_count = 0;
+#else
+  (void) context;
+#endif  // RMW_ERTPS_BATCHING
+  return true;
+}
+
+bool rmw_ertps_batch_add(
+  rmw_context_impl_t * context,
+  rtps::Writer * writer,
+  const uint8_t * data,
+  size_t length)
+{
+#ifdef RMW_ERTPS_BATCHING
+  rmw_ertps_batch_t * batch = &context->batch;
+  rtps::Lock lock{batch->mutex};
+
+  if (!batch->enabled || length > batch->max_bytes) {
+    return false;
+  }
+
+  if (batch->used + length > batch->max_bytes ||
+    batch->change_count == RMW_ERTPS_MAX_BATCH_CHANGES)
+  {
+    flush_batch(batch);
+  }
+
+  rcutils_time_point_value_t now;
+  rcutils_steady_time_now(&now);
+
+  if (0 == batch->change_count) {
+    batch->first_change_timestamp = now;
+  }
+
+  memcpy(&batch->buffer[batch->used], data, length);
+  batch->changes[batch->change_count].writer = writer;
+  batch->changes[batch->change_count].offset = batch->used;
+  batch->changes[batch->change_count].length = length;
+  batch->change_count++;
+  batch->used += length;
+
+  if (batch->used >= batch->max_bytes ||
+    now - batch->first_change_timestamp >= batch->max_latency)
+  {
+    flush_batch(batch);
+  }
+
+  return true;
+#else
+  (void) context;
+  (void) writer;
+  (void) data;
+  (void) length;
+
+  return false;
+#endif  // RMW_ERTPS_BATCHING
+}
+
+void rmw_ertps_batch_flush(
+  rmw_context_impl_t * context)
+{
+#ifdef RMW_ERTPS_BATCHING
+  rtps::Lock lock{context->batch.mutex};
+  flush_batch(&context->batch);
+#else
+  (void) context;
+#endif  // RMW_ERTPS_BATCHING
+}
+
+rmw_ret_t
+rmw_embeddedrtps_set_batching(
+  rmw_context_t * context,
+  bool enable,
+  size_t max_bytes,
+  rmw_time_t max_latency)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(context, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(context->impl, RMW_RET_INVALID_ARGUMENT);
+
+#ifdef RMW_ERTPS_BATCHING
+  rmw_ertps_batch_t * batch = &context->impl->batch;
+  rtps::Lock lock{batch->mutex};
+
+  flush_batch(batch);
+
+  batch->enabled = enable;
+  batch->max_bytes = (max_bytes < RMW_ERTPS_MAX_BATCH_SIZE) ? max_bytes : RMW_ERTPS_MAX_BATCH_SIZE;
+  batch->max_latency = rmw_time_total_nsec(max_latency);
+
+  return RMW_RET_OK;
+#else
+  (void) enable;
+  (void) max_bytes;
+  (void) max_latency;
+
+  RMW_SET_ERROR_MSG("Batching not available, build with RMW_ERTPS_BATCHING");
+  return RMW_RET_UNSUPPORTED;
+#endif  // RMW_ERTPS_BATCHING
+}
+
+rmw_ret_t
+rmw_embeddedrtps_flush_batch(
+  rmw_context_t * context)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(context, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(context->impl, RMW_RET_INVALID_ARGUMENT);
+
+#ifdef RMW_ERTPS_BATCHING
+  rmw_ertps_batch_flush(context->impl);
+
+  return RMW_RET_OK;
+#else
+  RMW_SET_ERROR_MSG("Batching not available, build with RMW_ERTPS_BATCHING");
+  return RMW_RET_UNSUPPORTED;
+#endif  // RMW_ERTPS_BATCHING
+}
@@ -12,30 +12,34 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <rmw/rmw.h>
-#include <rmw/error_handling.h>
-#include <rmw/allocators.h>
+#ifndef RMW_BATCHING_HPP_
+#define RMW_BATCHING_HPP_
 
+#include <rtps/rtps.h>
 
-rmw_wait_set_t *
-rmw_create_wait_set(
-  rmw_context_t * context,
-  size_t max_conditions)
+#include <rmw/types.h>
+
+#include "./types.hpp"
+
+#ifdef __cplusplus
+extern "C"
 {
-  (void)context;
-  (void)max_conditions;
+#endif
 
-  rmw_wait_set_t * rmw_wait_set = (rmw_wait_set_t *)rmw_allocate(
-    sizeof(rmw_wait_set_t));
+bool rmw_ertps_batch_init(
+  rmw_context_impl_t * context);
 
-  return rmw_wait_set;
-}
+bool rmw_ertps_batch_add(
+  rmw_context_impl_t * context,
+  rtps::Writer * writer,
+  const uint8_t * data,
+  size_t length);
 
-rmw_ret_t
-rmw_destroy_wait_set(
-  rmw_wait_set_t * wait_set)
-{
-  rmw_free(wait_set);
+void rmw_ertps_batch_flush(
+  rmw_context_impl_t * context);
 
-  return RMW_RET_OK;
+#ifdef __cplusplus
 }
+#endif
+
+#endif  // RMW_BATCHING_HPP_
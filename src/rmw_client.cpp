@@ -21,6 +21,8 @@
 
 #include "./utils.hpp"
 #include "./callbacks.hpp"
+#include "./rmw_pending_requests.hpp"
+#include "./rmw_wait_set.hpp"
 
 rmw_client_t *
 rmw_create_client(
@@ -63,8 +65,24 @@ rmw_create_client(
     }
 
     rmw_ertps_client_t * custom_client = reinterpret_cast<rmw_ertps_client_t *>(memory_node->data);
+    if (ERR_OK != sys_mutex_new(&custom_client->request_mutex)) {
+      RMW_SET_ERROR_MSG("failed to create client request mutex");
+      put_memory(&client_memory, memory_node);
+      goto fail;
+    }
     custom_client->rmw_handle = rmw_client;
     custom_client->owner_node = custom_node;
+    custom_client->wait_set_mask = 0;
+    custom_client->input_queue.head = NULL;
+    custom_client->input_queue.tail = NULL;
+    custom_client->input_queue.count = 0;
+    custom_client->on_new_data = NULL;
+    custom_client->on_new_data_user_data = NULL;
+    custom_client->priority = 0;
+    custom_client->local_service = NULL;
+    custom_client->local_sequence_id = 0;
+    rmw_ertps_pending_requests_init(custom_client);
+    custom_client->lifespan = rmw_ertps_lifespan_nsec(qos_policies->lifespan);
     custom_client->qos = *qos_policies;
 
     const rosidl_service_type_support_t * type_support_xrce = get_service_typesupport_handle(
@@ -105,22 +123,27 @@ rmw_create_client(
       goto fail;
     }
 
-    custom_client->reader = custom_node->context->domain->createReader(
-      *custom_node->context->participant,
-      res_topic_name,
-      res_type_name,
-      qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
-
+    // Clients of the same reply topic share a reader, replies are dispatched by related GUID
+    custom_client->reader = rmw_ertps_find_reply_reader(
+      custom_client, res_topic_name, res_type_name);
     if (nullptr == custom_client->reader) {
-      goto fail;
+      custom_client->reader = custom_node->context->domain->createReader(
+        *custom_node->context->participant,
+        res_topic_name,
+        res_type_name,
+        qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
+
+      if (nullptr == custom_client->reader) {
+        goto fail;
+      }
+
+      custom_client->reader->registerCallback(
+        generic_callback<rmw_ertps_client_t>,
+        custom_client->reader);
     }
 
-    custom_client->reader->registerCallback(
-      generic_callback<rmw_ertps_client_t>,
-      custom_client->reader);
-
-
     rmw_client->data = custom_client;
+    rmw_ertps_match_local_client(custom_client);
   }
   return rmw_client;
 
@@ -140,3 +163,23 @@ rmw_destroy_client(
   RMW_SET_ERROR_MSG("Function not implemented");
   return RMW_RET_UNSUPPORTED;
 }
+
+rmw_ret_t
+rmw_client_set_on_new_response_callback(
+  rmw_client_t * client,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  if (!client) {
+    RMW_SET_ERROR_MSG("client handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(client->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("client handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_ertps_set_on_new_data_callback(
+    reinterpret_cast<rmw_ertps_client_t *>(client->data), callback, user_data);
+
+  return RMW_RET_OK;
+}
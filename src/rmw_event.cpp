@@ -0,0 +1,328 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <rmw/error_handling.h>
+#include <rmw/event.h>
+#include <rmw/time.h>
+
+#include "./rmw_event.hpp"
+#include "./rmw_wait_set.hpp"
+#include "./utils.hpp"
+
+// Counts the deadline periods elapsed without samples, ready_mutex must be held
+static bool update_deadline(
+  rmw_ertps_subscription_events_t * events,
+  rcutils_time_point_value_t now)
+{
+  if (0 == events->deadline || now < events->deadline_reference + events->deadline) {
+    return false;
+  }
+
+  const rcutils_duration_value_t periods =
+    (now - events->deadline_reference) / events->deadline;
+  events->deadline_missed_total += static_cast<int32_t>(periods);
+  events->deadline_missed_change += static_cast<int32_t>(periods);
+  events->deadline_reference += periods * events->deadline;
+  return true;
+}
+
+void rmw_ertps_events_init(
+  rmw_ertps_subscription_t * subscription)
+{
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+  events->wait_set_mask = 0;
+
+  events->message_lost_total = 0;
+  events->message_lost_change = 0;
+  events->message_lost_callback = NULL;
+  events->message_lost_user_data = NULL;
+
+  events->deadline = 0;
+  const rmw_time_t deadline = subscription->qos.deadline;
+  if (!rmw_time_equal(deadline, (rmw_time_t)RMW_DURATION_INFINITE)) {
+    events->deadline = rmw_time_total_nsec(deadline);
+  }
+  rcutils_steady_time_now(&events->deadline_reference);
+  events->deadline_missed_total = 0;
+  events->deadline_missed_change = 0;
+  events->deadline_missed_unnotified = 0;
+  events->deadline_missed_callback = NULL;
+  events->deadline_missed_user_data = NULL;
+}
+
+void rmw_ertps_events_sample_stored(
+  rmw_ertps_subscription_t * subscription,
+  rcutils_time_point_value_t arrival_time)
+{
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+  // Periods missed before this sample are still reported
+  const int32_t previous = events->deadline_missed_change;
+  update_deadline(events, arrival_time);
+  events->deadline_missed_unnotified += events->deadline_missed_change - previous;
+  events->deadline_reference = arrival_time;
+}
+
+void rmw_ertps_events_sample_notified(
+  rmw_ertps_subscription_t * subscription)
+{
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+  if (0 == events->deadline) {
+    // Only set at creation
+    return;
+  }
+
+  int32_t missed;
+  rmw_event_callback_t callback;
+  const void * user_data;
+  {
+    rtps::Lock lock{subscription->owner_node->context->ready_mutex};
+    missed = events->deadline_missed_unnotified;
+    events->deadline_missed_unnotified = 0;
+    callback = events->deadline_missed_callback;
+    user_data = events->deadline_missed_user_data;
+  }
+
+  if (missed <= 0) {
+    return;
+  }
+  rmw_ertps_wait_set_notify(&events->wait_set_mask);
+  if (NULL != callback) {
+    callback(user_data, static_cast<size_t>(missed));
+  }
+}
+
+void rmw_ertps_events_sample_lost(
+  rmw_ertps_subscription_t * subscription)
+{
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+  rmw_event_callback_t callback;
+  const void * user_data;
+  {
+    rtps::Lock lock{subscription->owner_node->context->ready_mutex};
+    events->message_lost_total++;
+    events->message_lost_change++;
+    callback = events->message_lost_callback;
+    user_data = events->message_lost_user_data;
+  }
+
+  rmw_ertps_wait_set_notify(&events->wait_set_mask);
+  if (NULL != callback) {
+    callback(user_data, 1);
+  }
+}
+
+bool rmw_ertps_event_is_ready(
+  const rmw_event_t * event,
+  rcutils_time_point_value_t now)
+{
+  rmw_ertps_subscription_t * subscription =
+    reinterpret_cast<rmw_ertps_subscription_t *>(event->data);
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+
+  bool ready = false;
+  rmw_event_callback_t callback = NULL;
+  const void * user_data = NULL;
+  int32_t missed = 0;
+  {
+    rtps::Lock lock{subscription->owner_node->context->ready_mutex};
+    switch (event->event_type) {
+      case RMW_EVENT_MESSAGE_LOST:
+        ready = events->message_lost_change > 0;
+        break;
+      case RMW_EVENT_REQUESTED_DEADLINE_MISSED:
+        {
+          const int32_t previous = events->deadline_missed_change;
+          if (update_deadline(events, now)) {
+            missed = events->deadline_missed_change - previous;
+            callback = events->deadline_missed_callback;
+            user_data = events->deadline_missed_user_data;
+          }
+          ready = events->deadline_missed_change > 0;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Deadlines have no timer of their own, listeners hear about them when checked or
+  // when the late sample arrives
+  if (NULL != callback && missed > 0) {
+    callback(user_data, static_cast<size_t>(missed));
+  }
+
+  return ready;
+}
+
+rcutils_duration_value_t rmw_ertps_event_time_to_deadline(
+  const rmw_event_t * event,
+  rcutils_time_point_value_t now)
+{
+  if (RMW_EVENT_REQUESTED_DEADLINE_MISSED != event->event_type) {
+    return -1;
+  }
+
+  rmw_ertps_subscription_t * subscription =
+    reinterpret_cast<rmw_ertps_subscription_t *>(event->data);
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+
+  rtps::Lock lock{subscription->owner_node->context->ready_mutex};
+  if (0 == events->deadline) {
+    return -1;
+  }
+
+  const rcutils_duration_value_t left = events->deadline_reference + events->deadline - now;
+  return (left > 0) ? left : 0;
+}
+
+rmw_ret_t
+rmw_publisher_event_init(
+  rmw_event_t * rmw_event,
+  const rmw_publisher_t * publisher,
+  rmw_event_type_t event_type)
+{
+  (void)rmw_event;
+  (void)publisher;
+  (void)event_type;
+
+  RMW_SET_ERROR_MSG("Function not implemented");
+  return RMW_RET_UNSUPPORTED;
+}
+
+rmw_ret_t
+rmw_subscription_event_init(
+  rmw_event_t * rmw_event,
+  const rmw_subscription_t * subscription,
+  rmw_event_type_t event_type)
+{
+  if (!rmw_event || !subscription) {
+    RMW_SET_ERROR_MSG("event or subscription handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(subscription->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("subscription handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  switch (event_type) {
+    case RMW_EVENT_MESSAGE_LOST:
+    case RMW_EVENT_REQUESTED_DEADLINE_MISSED:
+      break;
+    default:
+      RMW_SET_ERROR_MSG("event type not supported");
+      return RMW_RET_UNSUPPORTED;
+  }
+
+  rmw_event->implementation_identifier = subscription->implementation_identifier;
+  rmw_event->data = subscription->data;
+  rmw_event->event_type = event_type;
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_take_event(
+  const rmw_event_t * event_handle,
+  void * event_info,
+  bool * taken)
+{
+  if (!event_handle || !event_info || !taken) {
+    RMW_SET_ERROR_MSG("event arguments are null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(event_handle->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("event handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rcutils_time_point_value_t now;
+  rcutils_steady_time_now(&now);
+  rmw_ertps_event_is_ready(event_handle, now);
+
+  rmw_ertps_subscription_t * subscription =
+    reinterpret_cast<rmw_ertps_subscription_t *>(event_handle->data);
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+
+  rtps::Lock lock{subscription->owner_node->context->ready_mutex};
+  switch (event_handle->event_type) {
+    case RMW_EVENT_MESSAGE_LOST:
+      {
+        rmw_message_lost_status_t * status =
+          reinterpret_cast<rmw_message_lost_status_t *>(event_info);
+        status->total_count = events->message_lost_total;
+        status->total_count_change = events->message_lost_change;
+        events->message_lost_change = 0;
+      }
+      break;
+    case RMW_EVENT_REQUESTED_DEADLINE_MISSED:
+      {
+        rmw_requested_deadline_missed_status_t * status =
+          reinterpret_cast<rmw_requested_deadline_missed_status_t *>(event_info);
+        status->total_count = events->deadline_missed_total;
+        status->total_count_change = events->deadline_missed_change;
+        events->deadline_missed_change = 0;
+      }
+      break;
+    default:
+      *taken = false;
+      RMW_SET_ERROR_MSG("event type not supported");
+      return RMW_RET_UNSUPPORTED;
+  }
+
+  *taken = true;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_event_set_callback(
+  rmw_event_t * event,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  if (!event) {
+    RMW_SET_ERROR_MSG("event handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(event->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("event handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_ertps_subscription_t * subscription =
+    reinterpret_cast<rmw_ertps_subscription_t *>(event->data);
+  rmw_ertps_subscription_events_t * events = &subscription->events;
+
+  size_t unread_count = 0;
+  {
+    rtps::Lock lock{subscription->owner_node->context->ready_mutex};
+    switch (event->event_type) {
+      case RMW_EVENT_MESSAGE_LOST:
+        events->message_lost_callback = callback;
+        events->message_lost_user_data = user_data;
+        unread_count = events->message_lost_change;
+        break;
+      case RMW_EVENT_REQUESTED_DEADLINE_MISSED:
+        events->deadline_missed_callback = callback;
+        events->deadline_missed_user_data = user_data;
+        unread_count = static_cast<size_t>(events->deadline_missed_change);
+        break;
+      default:
+        RMW_SET_ERROR_MSG("event type not supported");
+        return RMW_RET_UNSUPPORTED;
+    }
+  }
+
+  if (NULL != callback && unread_count > 0) {
+    callback(user_data, unread_count);
+  }
+
+  return RMW_RET_OK;
+}
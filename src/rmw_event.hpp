@@ -0,0 +1,51 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_EVENT_HPP_
+#define RMW_EVENT_HPP_
+
+#include <rcutils/time.h>
+
+#include <rmw/types.h>
+
+#include "./types.hpp"
+
+void rmw_ertps_events_init(
+  rmw_ertps_subscription_t * subscription);
+
+// Accounts a received sample, the context ready_mutex must be held
+void rmw_ertps_events_sample_stored(
+  rmw_ertps_subscription_t * subscription,
+  rcutils_time_point_value_t arrival_time);
+
+// Hands the deadlines found missed by the last stored sample to the waiters and listener,
+// the context ready_mutex must not be held
+void rmw_ertps_events_sample_notified(
+  rmw_ertps_subscription_t * subscription);
+
+// Accounts a sample dropped for lack of input buffers and wakes its waiters
+void rmw_ertps_events_sample_lost(
+  rmw_ertps_subscription_t * subscription);
+
+// Whether the event has unread status changes, deadlines are evaluated at `now`
+bool rmw_ertps_event_is_ready(
+  const rmw_event_t * event,
+  rcutils_time_point_value_t now);
+
+// Time left until the event deadline expires, or -1 if it has none
+rcutils_duration_value_t rmw_ertps_event_time_to_deadline(
+  const rmw_event_t * event,
+  rcutils_time_point_value_t now);
+
+#endif  // RMW_EVENT_HPP_
@@ -31,22 +31,15 @@ rmw_ret_t rmw_graph_publish(
 
   static uint8_t buffer[RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE];
 
-  // Encapsulation
-  buffer[0] = 0;
-  buffer[1] = 1;
-  buffer[2] = 0;
-  buffer[3] = 0;
+  size_t size;
+  uint8_t * serialized = rmw_ertps_serialize_message(
+    functions, &context->graph_info, 0, buffer, sizeof(buffer), &size);
 
-  ucdrBuffer mb;
-  ucdr_init_buffer(&mb, &buffer[4], sizeof(buffer) - 4);
-
-  bool written = functions->cdr_serialize(&context->graph_info, &mb);
-
-  if (written) {
-    size_t size = ucdr_buffer_length(&mb) + 4;
+  if (NULL != serialized) {
     context->graph_writer->newChange(
       rtps::ChangeKind_t::ALIVE,
-      buffer, size);
+      serialized, size);
+    rmw_ertps_release_output_buffer(serialized, buffer);
   } else {
     return RMW_RET_ERROR;
   }
@@ -16,22 +16,33 @@
 #include <rmw/allocators.h>
 #include <rmw/error_handling.h>
 
+#include "./types.hpp"
+#include "./utils.hpp"
 
 rmw_guard_condition_t *
 rmw_create_guard_condition(
   rmw_context_t * context)
 {
-  (void)context;
-
-  rmw_guard_condition_t * rmw_guard_condition = (rmw_guard_condition_t *)rmw_allocate(
-    sizeof(rmw_guard_condition_t));
+  rmw_guard_condition_t * rmw_guard_condition = reinterpret_cast<rmw_guard_condition_t *>(
+    rmw_allocate(sizeof(rmw_guard_condition_t)));
+  if (!rmw_guard_condition) {
+    RMW_SET_ERROR_MSG("failed to allocate memory");
+    return NULL;
+  }
 
   rmw_guard_condition->context = context;
   rmw_guard_condition->implementation_identifier = rmw_get_implementation_identifier();
-  rmw_guard_condition->data = (bool *)rmw_allocate(sizeof(bool));
-
-  bool * hasTriggered = (bool *)(rmw_guard_condition->data);
-  *hasTriggered = false;
+  rmw_guard_condition->data = rmw_allocate(sizeof(rmw_ertps_guard_condition_t));
+  if (!rmw_guard_condition->data) {
+    RMW_SET_ERROR_MSG("failed to allocate memory");
+    rmw_free(rmw_guard_condition);
+    return NULL;
+  }
+
+  rmw_ertps_guard_condition_t * custom_guard_condition =
+    reinterpret_cast<rmw_ertps_guard_condition_t *>(rmw_guard_condition->data);
+  custom_guard_condition->has_triggered = false;
+  custom_guard_condition->wait_set_mask = 0;
 
   return rmw_guard_condition;
 }
@@ -40,6 +51,12 @@ rmw_ret_t
 rmw_destroy_guard_condition(
   rmw_guard_condition_t * guard_condition)
 {
+  if (!guard_condition) {
+    RMW_SET_ERROR_MSG("guard condition handle is null");
+    return RMW_RET_ERROR;
+  }
+
+  rmw_free(guard_condition->data);
   rmw_free(guard_condition);
 
   return RMW_RET_OK;
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
 #include <time.h>
 
 #include <rtps/rtps.h>
@@ -21,6 +22,8 @@
 #include <rmw/error_handling.h>
 #include <rmw/allocators.h>
 
+#include "./rmw_batching.hpp"
+#include "./rmw_wait_set.hpp"
 #include "./types.hpp"
 #include "./utils.hpp"
 
@@ -67,16 +70,17 @@ rmw_init_options_copy(
   return RMW_RET_OK;
 }
 
+// New matches may make a service server available, wake whoever waits on the graph
 void matchedPub(void * args)
 {
-  (void) args;
-  // printf("Matched Pub: %s:%d\n", __FILE__, __LINE__);
+  rmw_context_impl_t * context_impl = reinterpret_cast<rmw_context_impl_t *>(args);
+  rmw_ertps_guard_condition_trigger(&context_impl->graph_guard_condition_data);
 }
 
 void matchedSub(void * args)
 {
-  (void) args;
-  // printf("Matched Sub: %s:%d\n", __FILE__, __LINE__);
+  rmw_context_impl_t * context_impl = reinterpret_cast<rmw_context_impl_t *>(args);
+  rmw_ertps_guard_condition_trigger(&context_impl->graph_guard_condition_data);
 }
 
 rmw_ret_t
@@ -117,14 +121,28 @@ rmw_init(
 
   rmw_context_impl_t * context_impl = reinterpret_cast<rmw_context_impl_t *>(memory_node->data);
 
-  extern sys_sem_t rmw_wait_sem;
-  sys_sem_new(&rmw_wait_sem, 0);
+  if (!rmw_ertps_batch_init(context_impl)) {
+    RMW_SET_ERROR_MSG("failed to create batch mutex");
+    put_memory(&session_memory, memory_node);
+    return RMW_RET_ERROR;
+  }
 
   // TODO: add domain number check?
   context_impl->domain = new rtps::Domain(options->domain_id);
   context_impl->participant = context_impl->domain->createParticipant();
   context->impl = context_impl;
 
+  context_impl->graph_guard_condition.implementation_identifier = embeddedrtps_identifier;
+  context_impl->graph_guard_condition.context = context;
+  context_impl->graph_guard_condition.data = &context_impl->graph_guard_condition_data;
+  context_impl->graph_guard_condition_data.has_triggered = false;
+  context_impl->graph_guard_condition_data.wait_set_mask = 0;
+
+  sys_mutex_new(&context_impl->ready_mutex);
+  memset(context_impl->ready_subscriptions, 0, sizeof(context_impl->ready_subscriptions));
+  memset(context_impl->ready_services, 0, sizeof(context_impl->ready_services));
+  memset(context_impl->ready_clients, 0, sizeof(context_impl->ready_clients));
+
 #ifdef RMW_ERTPS_GRAPH
   rmw_graph_init(context_impl);
 #endif  // RMW_ERTPS_GRAPH
@@ -140,14 +158,21 @@ rmw_init(
   rmw_ertps_init_publisher_memory(&publisher_memory, custom_publishers, RMW_ERTPS_MAX_PUBLISHERS);
   rmw_ertps_init_service_memory(&service_memory, custom_services, RMW_ERTPS_MAX_SERVICES);
   rmw_ertps_init_client_memory(&client_memory, custom_clients, RMW_ERTPS_MAX_CLIENTS);
+  rmw_ertps_init_wait_set_memory(&wait_set_memory, custom_wait_sets, RMW_ERTPS_MAX_WAIT_SETS);
+
+  // Ready bitmaps and wait set masks are indexed by the position in the static arrays
+  subscription_memory.is_dynamic_allowed = false;
+  service_memory.is_dynamic_allowed = false;
+  client_memory.is_dynamic_allowed = false;
+  wait_set_memory.is_dynamic_allowed = false;
 
   if (nullptr == context_impl->participant) {
     return RMW_RET_ERROR;
   }
 
   // Register callback to ensure that a publisher is matched to the writer before sending messages
-  context_impl->participant->registerOnNewPublisherMatchedCallback(matchedPub, nullptr);
-  context_impl->participant->registerOnNewSubscriberMatchedCallback(matchedSub, nullptr);
+  context_impl->participant->registerOnNewPublisherMatchedCallback(matchedPub, context_impl);
+  context_impl->participant->registerOnNewSubscriberMatchedCallback(matchedSub, context_impl);
 
   return RMW_RET_OK;
 }
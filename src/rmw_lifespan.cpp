@@ -0,0 +1,60 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <rmw_embeddedrtps/client.h>
+#include <rmw_embeddedrtps/service.h>
+
+#include <rmw/error_handling.h>
+
+#include "./types.hpp"
+#include "./utils.hpp"
+
+static void set_lifespan(
+  rmw_context_impl_t * context,
+  rcutils_duration_value_t * entity_lifespan,
+  rmw_time_t lifespan)
+{
+  rtps::Lock lock{context->ready_mutex};
+  *entity_lifespan = rmw_ertps_lifespan_nsec(lifespan);
+}
+
+rmw_ret_t
+rmw_embeddedrtps_service_set_lifespan(
+  const rmw_service_t * service,
+  rmw_time_t lifespan)
+{
+  if (!service || !is_ertps_rmw_identifier_valid(service->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid service handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  rmw_ertps_service_t * custom_service = reinterpret_cast<rmw_ertps_service_t *>(service->data);
+  set_lifespan(custom_service->owner_node->context, &custom_service->lifespan, lifespan);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_embeddedrtps_client_set_lifespan(
+  const rmw_client_t * client,
+  rmw_time_t lifespan)
+{
+  if (!client || !is_ertps_rmw_identifier_valid(client->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid client handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  rmw_ertps_client_t * custom_client = reinterpret_cast<rmw_ertps_client_t *>(client->data);
+  set_lifespan(custom_client->owner_node->context, &custom_client->lifespan, lifespan);
+  return RMW_RET_OK;
+}
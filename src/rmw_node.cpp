@@ -48,6 +48,8 @@ rmw_create_node(
 
     rmw_ertps_node_t * node_info = reinterpret_cast<rmw_ertps_node_t *>(memory_node->data);
     node_info->context = context->impl;
+    node_info->shared_service_writer = nullptr;
+    node_info->shared_service_reader = nullptr;
 
     node_handle = rmw_node_allocate();
     if (!node_handle) {
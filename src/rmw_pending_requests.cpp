@@ -0,0 +1,165 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./rmw_pending_requests.hpp"
+
+#include <rmw_embeddedrtps/client.h>
+
+#include <rmw/error_handling.h>
+
+#include "./utils.hpp"
+
+// Matched on the full id, as RTPS and local ids are far apart
+static rmw_ertps_pending_request_t * find_slot(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id)
+{
+  for (size_t i = 0; i < RMW_ERTPS_MAX_PENDING_REQUESTS; i++) {
+    rmw_ertps_pending_request_t * slot = &client->pending_requests[i];
+    if (slot->in_use && slot->sequence_id == sequence_id) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+int64_t rmw_ertps_sequence_id(
+  const rtps::SequenceNumber_t & sequence_number)
+{
+  return (static_cast<int64_t>(sequence_number.high) << 32) |
+         static_cast<int64_t>(sequence_number.low);
+}
+
+void rmw_ertps_pending_requests_init(
+  rmw_ertps_client_t * client)
+{
+  for (size_t i = 0; i < RMW_ERTPS_MAX_PENDING_REQUESTS; i++) {
+    client->pending_requests[i].in_use = false;
+  }
+  client->abandoned_requests = 0;
+
+  client->latency_last = 0;
+  client->latency_min = 0;
+  client->latency_max = 0;
+  client->latency_sum = 0;
+  client->latency_count = 0;
+}
+
+bool rmw_ertps_pending_request_has_room(
+  rmw_ertps_client_t * client,
+  rcutils_time_point_value_t now)
+{
+  bool has_room = false;
+  for (size_t i = 0; i < RMW_ERTPS_MAX_PENDING_REQUESTS; i++) {
+    rmw_ertps_pending_request_t * slot = &client->pending_requests[i];
+    if (slot->in_use && 0 != client->lifespan && now - slot->send_time >= client->lifespan) {
+      // A response arriving now would be discarded as expired anyway
+      slot->in_use = false;
+      client->abandoned_requests++;
+    }
+    has_room = has_room || !slot->in_use;
+  }
+  return has_room;
+}
+
+void rmw_ertps_pending_request_add(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id,
+  rcutils_time_point_value_t send_time)
+{
+  for (size_t i = 0; i < RMW_ERTPS_MAX_PENDING_REQUESTS; i++) {
+    rmw_ertps_pending_request_t * slot = &client->pending_requests[i];
+    if (!slot->in_use) {
+      slot->sequence_id = sequence_id;
+      slot->send_time = send_time;
+      slot->in_use = true;
+      return;
+    }
+  }
+}
+
+bool rmw_ertps_pending_request_is_known(
+  const rmw_ertps_client_t * client,
+  int64_t sequence_id)
+{
+  return NULL != find_slot(const_cast<rmw_ertps_client_t *>(client), sequence_id);
+}
+
+void rmw_ertps_pending_request_abandon(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id)
+{
+  rmw_ertps_pending_request_t * slot = find_slot(client, sequence_id);
+  if (NULL != slot) {
+    slot->in_use = false;
+    client->abandoned_requests++;
+  }
+}
+
+void rmw_ertps_pending_request_complete(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id)
+{
+  rcutils_time_point_value_t now;
+  rcutils_steady_time_now(&now);
+
+  rtps::Lock lock{client->owner_node->context->ready_mutex};
+
+  rmw_ertps_pending_request_t * slot = find_slot(client, sequence_id);
+  if (NULL == slot) {
+    return;
+  }
+  slot->in_use = false;
+
+  const rcutils_duration_value_t latency = now - slot->send_time;
+  client->latency_last = latency;
+  if (0 == client->latency_count || latency < client->latency_min) {
+    client->latency_min = latency;
+  }
+  if (latency > client->latency_max) {
+    client->latency_max = latency;
+  }
+  client->latency_sum += latency;
+  client->latency_count++;
+}
+
+rmw_ret_t
+rmw_embeddedrtps_client_get_latency(
+  const rmw_client_t * client,
+  rmw_embeddedrtps_client_latency_t * latency)
+{
+  if (!client || !is_ertps_rmw_identifier_valid(client->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid client handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!latency) {
+    RMW_SET_ERROR_MSG("latency is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  rmw_ertps_client_t * custom_client = reinterpret_cast<rmw_ertps_client_t *>(client->data);
+
+  rtps::Lock lock{custom_client->owner_node->context->ready_mutex};
+  latency->count = custom_client->latency_count;
+  latency->abandoned = custom_client->abandoned_requests;
+  latency->last = custom_client->latency_last;
+  latency->min = custom_client->latency_min;
+  latency->max = custom_client->latency_max;
+  latency->mean = 0;
+  if (custom_client->latency_count > 0) {
+    latency->mean = custom_client->latency_sum /
+      static_cast<rcutils_duration_value_t>(custom_client->latency_count);
+  }
+
+  return RMW_RET_OK;
+}
@@ -0,0 +1,51 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_PENDING_REQUESTS_HPP_
+#define RMW_PENDING_REQUESTS_HPP_
+
+#include <rcutils/time.h>
+
+#include "./types.hpp"
+
+int64_t rmw_ertps_sequence_id(
+  const rtps::SequenceNumber_t & sequence_number);
+
+void rmw_ertps_pending_requests_init(
+  rmw_ertps_client_t * client);
+
+// The context ready_mutex must be held by the callers of these four.
+// Requests older than the client lifespan are retired to make room. Requests are only
+// added after checking for room, with the client request_mutex held across both.
+bool rmw_ertps_pending_request_has_room(
+  rmw_ertps_client_t * client,
+  rcutils_time_point_value_t now);
+void rmw_ertps_pending_request_add(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id,
+  rcutils_time_point_value_t send_time);
+bool rmw_ertps_pending_request_is_known(
+  const rmw_ertps_client_t * client,
+  int64_t sequence_id);
+// Retires a request whose response will never be taken
+void rmw_ertps_pending_request_abandon(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id);
+
+// Retires the request and accounts its round trip latency
+void rmw_ertps_pending_request_complete(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id);
+
+#endif  // RMW_PENDING_REQUESTS_HPP_
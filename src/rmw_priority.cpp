@@ -0,0 +1,178 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <rmw_embeddedrtps/priority.h>
+
+#include <rmw/error_handling.h>
+
+#include "./types.hpp"
+#include "./utils.hpp"
+
+// Whether a should be serviced before b
+static bool is_more_urgent(
+  const rmw_embeddedrtps_ready_entity_t * a,
+  const rmw_embeddedrtps_ready_entity_t * b)
+{
+  if (a->priority != b->priority) {
+    return a->priority > b->priority;
+  }
+  return a->oldest_sample_time < b->oldest_sample_time;
+}
+
+// Insertion into the sorted output, the least urgent entry falls off when full
+static void insert_ready_entity(
+  rmw_embeddedrtps_ready_entity_t * entities,
+  size_t capacity,
+  size_t * count,
+  const rmw_embeddedrtps_ready_entity_t * entity)
+{
+  size_t position = *count;
+  while (position > 0 && is_more_urgent(entity, &entities[position - 1])) {
+    position--;
+  }
+
+  if (position >= capacity) {
+    return;
+  }
+
+  size_t last = (*count < capacity) ? *count : capacity - 1;
+  for (size_t i = last; i > position; i--) {
+    entities[i] = entities[i - 1];
+  }
+  entities[position] = *entity;
+
+  if (*count < capacity) {
+    (*count)++;
+  }
+}
+
+template<typename T>
+static void collect_ready_entities(
+  const uint32_t * registered,
+  const uint32_t * ready,
+  size_t words,
+  T * pool,
+  rmw_embeddedrtps_entity_kind_t kind,
+  sys_mutex_t * ready_mutex,
+  rmw_embeddedrtps_ready_entity_t * entities,
+  size_t capacity,
+  size_t * count)
+{
+  for (size_t w = 0; w < words; w++) {
+    const uint32_t candidates = registered[w] & ready[w];
+    for (size_t b = 0; candidates != 0 && b < 32; b++) {
+      if (!(candidates & (1UL << b))) {
+        continue;
+      }
+
+      T * element = &pool[w * 32 + b];
+      rmw_embeddedrtps_ready_entity_t entity;
+      entity.kind = kind;
+      entity.handle = element->rmw_handle;
+      entity.priority = element->priority;
+      {
+        rtps::Lock lock{*ready_mutex};
+        if (NULL == element->input_queue.head) {
+          // Taken meanwhile
+          continue;
+        }
+        entity.oldest_sample_time = reinterpret_cast<rmw_ertps_static_input_buffer_t *>(
+          element->input_queue.head->data)->arrival_time;
+      }
+
+      insert_ready_entity(entities, capacity, count, &entity);
+    }
+  }
+}
+
+rmw_ret_t
+rmw_embeddedrtps_subscription_set_priority(
+  const rmw_subscription_t * subscription,
+  uint8_t priority)
+{
+  if (!subscription || !is_ertps_rmw_identifier_valid(subscription->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid subscription handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  reinterpret_cast<rmw_ertps_subscription_t *>(subscription->data)->priority = priority;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_embeddedrtps_service_set_priority(
+  const rmw_service_t * service,
+  uint8_t priority)
+{
+  if (!service || !is_ertps_rmw_identifier_valid(service->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid service handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  reinterpret_cast<rmw_ertps_service_t *>(service->data)->priority = priority;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_embeddedrtps_client_set_priority(
+  const rmw_client_t * client,
+  uint8_t priority)
+{
+  if (!client || !is_ertps_rmw_identifier_valid(client->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid client handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  reinterpret_cast<rmw_ertps_client_t *>(client->data)->priority = priority;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+rmw_embeddedrtps_get_ready_entities(
+  const rmw_wait_set_t * wait_set,
+  rmw_embeddedrtps_ready_entity_t * entities,
+  size_t capacity,
+  size_t * count)
+{
+  if (!wait_set || !is_ertps_rmw_identifier_valid(wait_set->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid wait set handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!count || (capacity > 0 && !entities)) {
+    RMW_SET_ERROR_MSG("output arguments are null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  const rmw_ertps_wait_set_t * custom_wait_set =
+    reinterpret_cast<const rmw_ertps_wait_set_t *>(wait_set->data);
+  rmw_context_impl_t * context = custom_wait_set->context;
+
+  *count = 0;
+  collect_ready_entities(
+    custom_wait_set->subscriptions, context->ready_subscriptions,
+    RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SUBSCRIPTIONS), custom_subscriptions,
+    RMW_EMBEDDEDRTPS_ENTITY_SUBSCRIPTION, &context->ready_mutex,
+    entities, capacity, count);
+  collect_ready_entities(
+    custom_wait_set->services, context->ready_services,
+    RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SERVICES), custom_services,
+    RMW_EMBEDDEDRTPS_ENTITY_SERVICE, &context->ready_mutex,
+    entities, capacity, count);
+  collect_ready_entities(
+    custom_wait_set->clients, context->ready_clients,
+    RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_CLIENTS), custom_clients,
+    RMW_EMBEDDEDRTPS_ENTITY_CLIENT, &context->ready_mutex,
+    entities, capacity, count);
+
+  return RMW_RET_OK;
+}
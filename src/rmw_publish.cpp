@@ -17,6 +17,8 @@
 #include <rmw/error_handling.h>
 #include <rmw/rmw.h>
 
+#include "./callbacks.hpp"
+#include "./rmw_batching.hpp"
 #include "./types.hpp"
 #include "./utils.hpp"
 
@@ -26,7 +28,6 @@ rmw_publish(
   const void * ros_message,
   rmw_publisher_allocation_t * allocation)
 {
-  (void)allocation;
   rmw_ret_t ret = RMW_RET_OK;
   if (!publisher) {
     RMW_SET_ERROR_MSG("publisher pointer is null");
@@ -40,33 +41,60 @@ rmw_publish(
   } else if (!publisher->data) {
     RMW_SET_ERROR_MSG("publisher imp is null");
     ret = RMW_RET_ERROR;
+  } else if (allocation && !is_ertps_rmw_identifier_valid(allocation->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("allocation handle not from this implementation");
+    ret = RMW_RET_ERROR;
   } else {
     rmw_ertps_publisher_t * custom_publisher =
       reinterpret_cast<rmw_ertps_publisher_t *>(publisher->data);
     const message_type_support_callbacks_t * functions = custom_publisher->type_support_callbacks;
 
-    // TODO(pablogs): Consider using a different allocator for the message.
-    static uint8_t buffer[RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE];
+    static uint8_t static_buffer[RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE];
+
+    // Preallocated buffers are sized for the worst case of the type
+    uint8_t * buffer = static_buffer;
+    size_t buffer_size = sizeof(static_buffer);
+    if (allocation) {
+      rmw_ertps_allocation_t * custom_allocation =
+        reinterpret_cast<rmw_ertps_allocation_t *>(allocation->data);
+      buffer = custom_allocation->buffer;
+      buffer_size = custom_allocation->size;
+    }
+
+    size_t size;
+    uint8_t * serialized = rmw_ertps_serialize_message(
+      functions, ros_message, custom_publisher->plain_size, buffer, buffer_size, &size);
 
-    // TODO(pablogs): Consider refactoring CDR encapsulation
-    // Encapsulation
-    buffer[0] = 0;
-    buffer[1] = 1;
-    buffer[2] = 0;
-    buffer[3] = 0;
+    if (NULL != serialized) {
+      // Batched samples and samples only read locally get no sequence number
+      rtps::SequenceNumber_t sequence_number{};
 
-    ucdrBuffer mb;
-    ucdr_init_buffer(&mb, &buffer[4], sizeof(buffer) - 4);
+      // Without matched remote readers nobody needs the RTPS write
+      if (0 != custom_publisher->writer->getProxiesCount() &&
+        !rmw_ertps_batch_add(
+          custom_publisher->owner_node->context,
+          custom_publisher->writer,
+          serialized, size))
+      {
+        const rtps::CacheChange * change = custom_publisher->writer->newChange(
+          rtps::ChangeKind_t::ALIVE,
+          serialized, size);
+        if (NULL == change) {
+          RMW_SET_ERROR_MSG("writer history full");
+          ret = RMW_RET_ERROR;
+        } else {
+          sequence_number = change->sequenceNumber;
+        }
+      }
 
-    bool written = functions->cdr_serialize(ros_message, &mb);
+      // Same participant subscriptions skip the RTPS loopback
+      if (RMW_RET_OK == ret) {
+        rmw_ertps_deliver_to_local_subscriptions(
+          custom_publisher, serialized, size, sequence_number);
+      }
 
-    if (written) {
-      size_t size = ucdr_buffer_length(&mb) + 4;
-      custom_publisher->writer->newChange(
-        rtps::ChangeKind_t::ALIVE,
-        buffer, size);
-    } else if (!written) {
-      RMW_SET_ERROR_MSG("error publishing message");
+      rmw_ertps_release_output_buffer(serialized, buffer);
+    } else {
       ret = RMW_RET_ERROR;
     }
   }
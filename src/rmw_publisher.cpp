@@ -29,22 +29,37 @@ rmw_init_publisher_allocation(
   const rosidl_runtime_c__Sequence__bound * message_bounds,
   rmw_publisher_allocation_t * allocation)
 {
-  (void)type_support;
-  (void)message_bounds;
-  (void)allocation;
+  RMW_CHECK_ARGUMENT_FOR_NULL(type_support, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
 
-  RMW_SET_ERROR_MSG("Function not implemented");
-  return RMW_RET_UNSUPPORTED;
+  rmw_ertps_allocation_t * custom_allocation =
+    rmw_ertps_create_allocation(type_support, message_bounds);
+  if (NULL == custom_allocation) {
+    return RMW_RET_ERROR;
+  }
+
+  allocation->implementation_identifier = rmw_get_implementation_identifier();
+  allocation->data = custom_allocation;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
 rmw_fini_publisher_allocation(
   rmw_publisher_allocation_t * allocation)
 {
-  (void) allocation;
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
 
-  RMW_SET_ERROR_MSG("Function not implemented");
-  return RMW_RET_UNSUPPORTED;
+  if (!is_ertps_rmw_identifier_valid(allocation->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("allocation handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_free(allocation->data);
+  allocation->implementation_identifier = NULL;
+  allocation->data = NULL;
+
+  return RMW_RET_OK;
 }
 
 rmw_publisher_t *
@@ -112,6 +127,8 @@ rmw_create_publisher(
       goto fail;
     }
 
+    custom_publisher->plain_size = rmw_ertps_get_plain_message_size(type_support);
+
     static char full_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
     static char type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
 
@@ -138,6 +155,7 @@ rmw_create_publisher(
 #endif  // RMW_ERTPS_GRAPH
 
     rmw_publisher->data = custom_publisher;
+    rmw_ertps_match_local_publisher(custom_publisher);
   }
 
   return rmw_publisher;
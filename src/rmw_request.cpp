@@ -12,10 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <rcutils/time.h>
+
 #include <rmw/rmw.h>
 #include <rmw/error_handling.h>
+#include "./callbacks.hpp"
+#include "./rmw_pending_requests.hpp"
+#include "./rmw_wait_set.hpp"
 #include "./utils.hpp"
 
+// Requests that skip RTPS get ids from a range RTPS writers never reach
+static const int64_t local_sequence_id_base = 1LL << 62;
+
 rmw_ret_t
 rmw_send_request(
   const rmw_client_t * client,
@@ -36,27 +44,60 @@ rmw_send_request(
 
   static uint8_t buffer[RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE];
 
-  // Encapsulation
-  buffer[0] = 0;
-  buffer[1] = 1;
-  buffer[2] = 0;
-  buffer[3] = 0;
-
-  ucdrBuffer mb;
-  ucdr_init_buffer(&mb, &buffer[4], sizeof(buffer) - 4);
-
-  bool written = functions->cdr_serialize(ros_request, &mb);
-
-  if (written) {
-    size_t size = ucdr_buffer_length(&mb) + 4;
-    const rtps::CacheChange * cache_change = custom_client->writer->newChange(
-      rtps::ChangeKind_t::ALIVE,
-      buffer, size);
-    *sequence_id =
-      (int64_t)cache_change->sequenceNumber.high << 32 |
-      (int64_t) cache_change->sequenceNumber.low;  // NO_LINT
-  } else if (!written) {
-    RMW_SET_ERROR_MSG("error send request");
+  size_t size;
+  uint8_t * serialized = rmw_ertps_serialize_message(
+    functions, ros_request, 0, buffer, sizeof(buffer), &size);
+
+  if (NULL != serialized) {
+    rcutils_time_point_value_t send_time;
+    rcutils_steady_time_now(&send_time);
+
+    rtps::SequenceNumber_t sequence_number;
+    {
+      // Responses to this client wait until the request is recorded
+      rtps::Lock request_lock{custom_client->request_mutex};
+
+      // Evicting a request instead would silently drop its response
+      bool has_room;
+      {
+        rtps::Lock lock{custom_client->owner_node->context->ready_mutex};
+        has_room = rmw_ertps_pending_request_has_room(custom_client, send_time);
+      }
+      if (!has_room) {
+        rmw_ertps_release_output_buffer(serialized, buffer);
+        RMW_SET_ERROR_MSG("RMW_ERTPS_MAX_PENDING_REQUESTS requests already in flight");
+        return RMW_RET_ERROR;
+      }
+
+      if (NULL != custom_client->local_service &&
+        0 == custom_client->writer->getProxiesCount())
+      {
+        // Nobody but the service of the same context can answer
+        custom_client->local_sequence_id++;
+        *sequence_id = local_sequence_id_base + custom_client->local_sequence_id;
+        sequence_number.high = *sequence_id >> 32;
+        sequence_number.low = *sequence_id & 0xFFFFFFFF;
+      } else {
+        const rtps::CacheChange * cache_change = custom_client->writer->newChange(
+          rtps::ChangeKind_t::ALIVE,
+          serialized, size);
+        if (NULL == cache_change) {
+          rmw_ertps_release_output_buffer(serialized, buffer);
+          RMW_SET_ERROR_MSG("writer history full");
+          return RMW_RET_ERROR;
+        }
+        sequence_number = cache_change->sequenceNumber;
+        *sequence_id = rmw_ertps_sequence_id(sequence_number);
+      }
+
+      rtps::Lock lock{custom_client->owner_node->context->ready_mutex};
+      rmw_ertps_pending_request_add(custom_client, *sequence_id, send_time);
+    }
+
+    // A service of the same context gets the request directly
+    rmw_ertps_deliver_to_local_service(custom_client, serialized, size, sequence_number);
+    rmw_ertps_release_output_buffer(serialized, buffer);
+  } else {
     return RMW_RET_ERROR;
   }
 
@@ -81,44 +122,29 @@ rmw_take_request(
 
   rmw_ertps_service_t * custom_service = reinterpret_cast<rmw_ertps_service_t *>(service->data);
 
-  // Find first related item in static buffer memory pool
-  rmw_ertps_mempool_item_t * static_buffer_item =
-    rmw_ertps_find_static_input_buffer_by_owner(reinterpret_cast<void *>(custom_service));
+  // Claim the oldest sample, concurrent takers never get the same one
+  rmw_ertps_mempool_item_t * static_buffer_item = rmw_ertps_ready_pop(custom_service);
   if (static_buffer_item == NULL) {
-    return RMW_RET_ERROR;
+    return RMW_RET_OK;
   }
 
   rmw_ertps_static_input_buffer_t * static_buffer =
     reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
 
-  std::copy(
-    static_buffer->writer_guid.prefix.id.begin(),
-    static_buffer->writer_guid.prefix.id.begin() + 12, request_header->request_id.writer_guid);
-  std::copy(
-    static_buffer->writer_guid.prefix.id.begin() + 12,
-    static_buffer->writer_guid.prefix.id.begin() + 15, &request_header->request_id.writer_guid[12]);
-  std::copy(
-    static_buffer->writer_guid.prefix.id.begin() + 15,
-    static_buffer->writer_guid.prefix.id.begin() + 16, &request_header->request_id.writer_guid[15]);
+  rmw_ertps_guid_to_writer_guid(
+    static_buffer->writer_guid, request_header->request_id.writer_guid);
   request_header->request_id.sequence_number =
-    ((int64_t) static_buffer->sequence_number.high << 32) |
-    (int64_t) static_buffer->sequence_number.low;  // NO_LINT
-
+    rmw_ertps_sequence_id(static_buffer->sequence_number);
 
   const rosidl_message_type_support_t * req_members =
     custom_service->type_support_callbacks->request_members_();
   const message_type_support_callbacks_t * functions =
     reinterpret_cast<const message_type_support_callbacks_t *>(req_members->data);
 
-  ucdrBuffer temp_buffer;
-  ucdr_init_buffer(
-    &temp_buffer,
-    &static_buffer->buffer[4],
-    static_buffer->length - 4);
-
-  bool deserialize_rv = functions->cdr_deserialize(&temp_buffer, ros_request);
+  bool deserialize_rv = rmw_ertps_deserialize_static_input_buffer(
+    static_buffer, functions, 0, NULL, ros_request);
 
-  put_memory(&static_buffer_memory, static_buffer_item);
+  rmw_ertps_release_static_input_buffer(static_buffer_item);
 
   if (taken != NULL) {
     *taken = deserialize_rv;
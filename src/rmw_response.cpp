@@ -17,18 +17,86 @@
 #include <rmw/error_handling.h>
 #include <rmw/rmw.h>
 
+#include <rmw_embeddedrtps/client.h>
+#include <rmw_embeddedrtps/service.h>
 
+#include "./callbacks.hpp"
 #include "./types.hpp"
+#include "./rmw_pending_requests.hpp"
+#include "./rmw_wait_set.hpp"
 #include "./utils.hpp"
 
+// Serialization buffer of rmw_send_response, shared by every service
+static sys_mutex_t response_mutex;
+static bool response_mutex_created = false;
+static uint8_t response_buffer[RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE];
+
+bool rmw_ertps_init_response_buffer()
+{
+  rtps::Lock lock{service_memory.memory_mutex};
+  if (!response_mutex_created) {
+    response_mutex_created = ERR_OK == sys_mutex_new(&response_mutex);
+  }
+  return response_mutex_created;
+}
+
+// Serializes and sends a response, the buffer must not be used concurrently. A client
+// of the same context given the response must be notified once the buffer is free.
+static rmw_ret_t send_response(
+  rmw_ertps_service_t * custom_service,
+  const rmw_request_id_t * request_header,
+  const void * ros_response,
+  uint8_t * buffer,
+  size_t buffer_size,
+  rmw_ertps_local_response_t * local_response)
+{
+  rtps::Guid_t related_guid;
+  rtps::SequenceNumber_t related_sequence_no;
+
+  rmw_ertps_writer_guid_to_guid(request_header->writer_guid, related_guid);
+  related_sequence_no.high = request_header->sequence_number >> 32;
+  related_sequence_no.low = request_header->sequence_number & 0xFFFFFFFF;
+
+  const rosidl_message_type_support_t * res_members =
+    custom_service->type_support_callbacks->response_members_();
+  const message_type_support_callbacks_t * functions =
+    reinterpret_cast<const message_type_support_callbacks_t *>(res_members->data);
+
+  local_response->client = NULL;
+
+  size_t size;
+  uint8_t * serialized = rmw_ertps_serialize_message(
+    functions, ros_response, 0, buffer, buffer_size, &size);
+  if (NULL == serialized) {
+    return RMW_RET_ERROR;
+  }
+
+  // Clients of the same context skip RTPS
+  if (rmw_ertps_deliver_to_local_client(
+      custom_service, serialized, size, related_guid, related_sequence_no, local_response))
+  {
+    rmw_ertps_release_output_buffer(serialized, buffer);
+    return RMW_RET_OK;
+  }
+
+  const rtps::CacheChange * cache_change = custom_service->writer->newChange(
+    rtps::ChangeKind_t::ALIVE,
+    serialized, size, related_guid, related_sequence_no);
+  rmw_ertps_release_output_buffer(serialized, buffer);
+  if (NULL == cache_change) {
+    RMW_SET_ERROR_MSG("writer history full");
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
+
 rmw_ret_t
 rmw_send_response(
   const rmw_service_t * service,
   rmw_request_id_t * request_header,
   void * ros_response)
 {
-  rmw_ret_t ret = RMW_RET_OK;
-
   if (!is_ertps_rmw_identifier_valid(service->implementation_identifier)) {
     RMW_SET_ERROR_MSG("Wrong implementation");
     return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
@@ -37,49 +105,84 @@ rmw_send_response(
   rmw_ertps_service_t * custom_service =
     reinterpret_cast<rmw_ertps_service_t *>(service->data);
 
-  rtps::Guid_t related_guid;
-  rtps::SequenceNumber_t related_sequence_no;
+  rmw_ertps_local_response_t local_response;
+  rmw_ret_t ret;
+  {
+    // Only held while the shared buffer is in use, a local client listener may respond
+    rtps::Lock lock{response_mutex};
+    ret = send_response(
+      custom_service, request_header, ros_response,
+      response_buffer, sizeof(response_buffer), &local_response);
+  }
+  rmw_ertps_notify_local_client(&local_response);
 
-  std::copy(
-    &request_header->writer_guid[0], &request_header->writer_guid[12],
-    related_guid.prefix.id.begin());
-  std::copy(
-    &request_header->writer_guid[12], &request_header->writer_guid[15],
-    related_guid.prefix.id.begin() + 12);
-  std::copy(
-    &request_header->writer_guid[15], &request_header->writer_guid[16],
-    related_guid.prefix.id.begin() + 15);
-  related_sequence_no.high = request_header->sequence_number >> 32;
-  related_sequence_no.low = request_header->sequence_number & 0xFFFFFFFF;
+  return ret;
+}
+
+rmw_ret_t
+rmw_embeddedrtps_send_response_with_buffer(
+  const rmw_service_t * service,
+  rmw_request_id_t * request_header,
+  void * ros_response,
+  uint8_t * buffer,
+  size_t buffer_size)
+{
+  if (!service || !is_ertps_rmw_identifier_valid(service->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid service handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!request_header || !ros_response) {
+    RMW_SET_ERROR_MSG("request_header or ros_response is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!buffer || buffer_size < 4) {
+    RMW_SET_ERROR_MSG("invalid serialization buffer");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  rmw_ertps_local_response_t local_response;
+  rmw_ret_t ret = send_response(
+    reinterpret_cast<rmw_ertps_service_t *>(service->data),
+    request_header, ros_response, buffer, buffer_size, &local_response);
+  rmw_ertps_notify_local_client(&local_response);
+
+  return ret;
+}
+
+// Deserializes a claimed response and retires its request
+static rmw_ret_t take_response(
+  rmw_ertps_client_t * custom_client,
+  rmw_ertps_mempool_item_t * static_buffer_item,
+  rmw_service_info_t * request_header,
+  void * ros_response,
+  bool * taken)
+{
+  rmw_ertps_static_input_buffer_t * static_buffer =
+    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
 
+  rmw_ertps_guid_to_writer_guid(
+    static_buffer->related_writer_guid, request_header->request_id.writer_guid);
+  request_header->request_id.sequence_number =
+    rmw_ertps_sequence_id(static_buffer->related_sequence_number);
+  rmw_ertps_pending_request_complete(custom_client, request_header->request_id.sequence_number);
   const rosidl_message_type_support_t * res_members =
-    custom_service->type_support_callbacks->response_members_();
+    custom_client->type_support_callbacks->response_members_();
   const message_type_support_callbacks_t * functions =
     reinterpret_cast<const message_type_support_callbacks_t *>(res_members->data);
 
-  static uint8_t buffer[RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE];
-
-  // Encapsulation
-  buffer[0] = 0;
-  buffer[1] = 1;
-  buffer[2] = 0;
-  buffer[3] = 0;
+  bool deserialize_rv = rmw_ertps_deserialize_static_input_buffer(
+    static_buffer, functions, 0, NULL, ros_response);
 
-  ucdrBuffer mb;
-  ucdr_init_buffer(&mb, &buffer[4], sizeof(buffer) - 4);
+  rmw_ertps_release_static_input_buffer(static_buffer_item);
 
-  bool written = functions->cdr_serialize(ros_response, &mb);
+  if (taken != NULL) {
+    *taken = deserialize_rv;
+  }
 
-  if (written) {
-    size_t size = ucdr_buffer_length(&mb) + 4;
-    custom_service->writer->newChange(
-      rtps::ChangeKind_t::ALIVE,
-      buffer, size, related_guid, related_sequence_no);
-  } else if (!written) {
-    RMW_SET_ERROR_MSG("error publishing message");
-    ret = RMW_RET_ERROR;
+  if (!deserialize_rv) {
+    RMW_SET_ERROR_MSG("Typesupport desserialize error.");
+    return RMW_RET_ERROR;
   }
-  return ret;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
@@ -100,56 +203,42 @@ rmw_take_response(
 
   rmw_ertps_client_t * custom_client = reinterpret_cast<rmw_ertps_client_t *>(client->data);
 
-  // Find first related item in static buffer memory pool
-  rmw_ertps_mempool_item_t * static_buffer_item =
-    rmw_ertps_find_static_input_buffer_by_owner(reinterpret_cast<void *>(custom_client));
+  // Claim the oldest sample, concurrent takers never get the same one
+  rmw_ertps_mempool_item_t * static_buffer_item = rmw_ertps_ready_pop(custom_client);
   if (static_buffer_item == NULL) {
-    return RMW_RET_ERROR;
+    return RMW_RET_OK;
   }
 
-  rmw_ertps_static_input_buffer_t * static_buffer =
-    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
-
-  std::copy(
-    static_buffer->related_writer_guid.prefix.id.begin(),
-    static_buffer->related_writer_guid.prefix.id.begin() + 12,
-    request_header->request_id.writer_guid);
-  std::copy(
-    static_buffer->related_writer_guid.prefix.id.begin() + 12,
-    static_buffer->related_writer_guid.prefix.id.begin() + 15,
-    &request_header->request_id.writer_guid[12]);
-  std::copy(
-    static_buffer->related_writer_guid.prefix.id.begin() + 15,
-    static_buffer->related_writer_guid.prefix.id.begin() + 16,
-    &request_header->request_id.writer_guid[15]);
-  request_header->request_id.sequence_number =
-    ((int64_t) static_buffer->related_sequence_number.high << 32) |
-    static_buffer->related_sequence_number.low;                                                                                                            // NOLINT
-  const rosidl_message_type_support_t * res_members =
-    custom_client->type_support_callbacks->response_members_();
-  const message_type_support_callbacks_t * functions =
-    reinterpret_cast<const message_type_support_callbacks_t *>(res_members->data);
-
-  ucdrBuffer temp_buffer;
-  ucdr_init_buffer(
-    &temp_buffer,
-    &static_buffer->buffer[4],
-    static_buffer->length - 4);
-
-  bool deserialize_rv = functions->cdr_deserialize(
-    &temp_buffer,
-    ros_response);
-
-  put_memory(&static_buffer_memory, static_buffer_item);
+  return take_response(custom_client, static_buffer_item, request_header, ros_response, taken);
+}
 
+rmw_ret_t
+rmw_embeddedrtps_take_response_by_sequence_id(
+  const rmw_client_t * client,
+  int64_t sequence_id,
+  rmw_service_info_t * request_header,
+  void * ros_response,
+  bool * taken)
+{
   if (taken != NULL) {
-    *taken = deserialize_rv;
+    *taken = false;
   }
 
-  if (!deserialize_rv) {
-    RMW_SET_ERROR_MSG("Typesupport desserialize error.");
-    return RMW_RET_ERROR;
+  if (!client || !is_ertps_rmw_identifier_valid(client->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("invalid client handle");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!request_header || !ros_response) {
+    RMW_SET_ERROR_MSG("request_header or ros_response is null");
+    return RMW_RET_INVALID_ARGUMENT;
   }
 
-  return RMW_RET_OK;
+  rmw_ertps_client_t * custom_client = reinterpret_cast<rmw_ertps_client_t *>(client->data);
+
+  rmw_ertps_mempool_item_t * static_buffer_item =
+    rmw_ertps_ready_pop(custom_client, sequence_id);
+  if (static_buffer_item == NULL) {
+    return RMW_RET_OK;
+  }
+
+  return take_response(custom_client, static_buffer_item, request_header, ros_response, taken);
 }
@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <rosidl_typesupport_microxrcedds_c/identifier.h>
+#include <rosidl_typesupport_microxrcedds_c/message_type_support.h>
+
 #include <rmw/rmw.h>
 #include <rmw/error_handling.h>
 
@@ -49,10 +52,33 @@ rmw_get_serialized_message_size(
   const rosidl_runtime_c__Sequence__bound * message_bounds,
   size_t * size)
 {
-  (void)type_support;
   (void)message_bounds;
-  (void)size;
 
-  RMW_SET_ERROR_MSG("Function not implemented");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(type_support, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(size, RMW_RET_INVALID_ARGUMENT);
+
+  const rosidl_message_type_support_t * type_support_xrce = get_message_typesupport_handle(
+    type_support, ROSIDL_TYPESUPPORT_MICROXRCEDDS_C__IDENTIFIER_VALUE);
+  if (NULL == type_support_xrce) {
+    RMW_SET_ERROR_MSG("Undefined type support");
+    return RMW_RET_ERROR;
+  }
+
+  const message_type_support_callbacks_t * functions =
+    (const message_type_support_callbacks_t *)type_support_xrce->data;
+
+  bool full_bounded = true;
+  size_t max_size = functions->max_serialized_size(&full_bounded);
+
+  if (!full_bounded) {
+    // rosidl does not define the contents of message bounds yet,
+    // so the worst case of unbounded types cannot be computed
+    RMW_SET_ERROR_MSG("Unbounded types not supported");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  // Account for CDR encapsulation
+  *size = max_size + 4;
+
+  return RMW_RET_OK;
 }
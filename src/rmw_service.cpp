@@ -21,6 +21,8 @@
 
 #include "./utils.hpp"
 #include "./callbacks.hpp"
+#include "./rmw_shared_services.hpp"
+#include "./rmw_wait_set.hpp"
 
 rmw_service_t *
 rmw_create_service(
@@ -56,6 +58,11 @@ rmw_create_service(
       const_cast<char *>(rmw_service->service_name),
       service_name, strlen(service_name) + 1);
 
+    if (!rmw_ertps_init_response_buffer()) {
+      RMW_SET_ERROR_MSG("failed to create response buffer mutex");
+      goto fail;
+    }
+
     rmw_ertps_node_t * custom_node = reinterpret_cast<rmw_ertps_node_t *>(node->data);
     rmw_ertps_mempool_item_t * memory_node = get_memory(&service_memory);
     if (!memory_node) {
@@ -68,6 +75,14 @@ rmw_create_service(
     custom_service->rmw_handle = rmw_service;
 
     custom_service->owner_node = custom_node;
+    custom_service->wait_set_mask = 0;
+    custom_service->input_queue.head = NULL;
+    custom_service->input_queue.tail = NULL;
+    custom_service->input_queue.count = 0;
+    custom_service->on_new_data = NULL;
+    custom_service->on_new_data_user_data = NULL;
+    custom_service->priority = 0;
+    custom_service->lifespan = rmw_ertps_lifespan_nsec(qos_policies->lifespan);
     custom_service->qos = *qos_policies;
 
     const rosidl_service_type_support_t * type_support_xrce = get_service_typesupport_handle(
@@ -86,44 +101,55 @@ rmw_create_service(
       goto fail;
     }
 
-    char req_type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
-    char res_type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
-    generate_service_types(
-      custom_service->type_support_callbacks, req_type_name, res_type_name,
-      RMW_ERTPS_TYPE_NAME_MAX_LENGTH);
-
-    char req_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
-    char res_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
-    generate_service_topics(
-      service_name, req_topic_name, res_topic_name,
-      RMW_ERTPS_TOPIC_NAME_MAX_LENGTH);
-
-    custom_service->writer = custom_node->context->domain->createWriter(
-      *custom_node->context->participant,
-      res_topic_name,
-      res_type_name,
-      qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
-
-    if (nullptr == custom_service->writer) {
-      goto fail;
+    custom_service->shared_index = rmw_ertps_shared_service_index(custom_node, service_name);
+    if (0 != custom_service->shared_index) {
+      // Parameter services of a node share their endpoints
+      if (!rmw_ertps_shared_service_endpoints(
+          custom_node, service_name, qos_policies,
+          &custom_service->writer, &custom_service->reader))
+      {
+        goto fail;
+      }
+    } else {
+      char req_type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
+      char res_type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
+      generate_service_types(
+        custom_service->type_support_callbacks, req_type_name, res_type_name,
+        RMW_ERTPS_TYPE_NAME_MAX_LENGTH);
+
+      char req_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
+      char res_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
+      generate_service_topics(
+        service_name, req_topic_name, res_topic_name,
+        RMW_ERTPS_TOPIC_NAME_MAX_LENGTH);
+
+      custom_service->writer = custom_node->context->domain->createWriter(
+        *custom_node->context->participant,
+        res_topic_name,
+        res_type_name,
+        qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
+
+      if (nullptr == custom_service->writer) {
+        goto fail;
+      }
+
+      custom_service->reader = custom_node->context->domain->createReader(
+        *custom_node->context->participant,
+        req_topic_name,
+        req_type_name,
+        qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
+
+      if (nullptr == custom_service->reader) {
+        goto fail;
+      }
+
+      custom_service->reader->registerCallback(
+        generic_callback<rmw_ertps_service_t>,
+        custom_service->reader);
     }
 
-    custom_service->reader = custom_node->context->domain->createReader(
-      *custom_node->context->participant,
-      req_topic_name,
-      req_type_name,
-      qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
-
-    if (nullptr == custom_service->reader) {
-      goto fail;
-    }
-
-    custom_service->reader->registerCallback(
-      generic_callback<rmw_ertps_service_t>,
-      custom_service->reader);
-
-
     rmw_service->data = custom_service;
+    rmw_ertps_match_local_service(custom_service);
   }
   return rmw_service;
 
@@ -143,3 +169,23 @@ rmw_destroy_service(
   RMW_SET_ERROR_MSG("Function not implemented");
   return RMW_RET_UNSUPPORTED;
 }
+
+rmw_ret_t
+rmw_service_set_on_new_request_callback(
+  rmw_service_t * service,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  if (!service) {
+    RMW_SET_ERROR_MSG("service handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(service->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("service handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_ertps_set_on_new_data_callback(
+    reinterpret_cast<rmw_ertps_service_t *>(service->data), callback, user_data);
+
+  return RMW_RET_OK;
+}
@@ -0,0 +1,53 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <rtps/rtps.h>
+
+#include <rmw/rmw.h>
+#include <rmw/error_handling.h>
+
+#include "./types.hpp"
+#include "./utils.hpp"
+
+rmw_ret_t rmw_service_server_is_available(
+  const rmw_node_t * node,
+  const rmw_client_t * client,
+  bool * is_available)
+{
+  if (!node) {
+    RMW_SET_ERROR_MSG("node handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!client) {
+    RMW_SET_ERROR_MSG("client handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_available) {
+    RMW_SET_ERROR_MSG("is_available is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(node->implementation_identifier) ||
+    !is_ertps_rmw_identifier_valid(client->implementation_identifier))
+  {
+    RMW_SET_ERROR_MSG("handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_ertps_client_t * custom_client = reinterpret_cast<rmw_ertps_client_t *>(client->data);
+
+  // Requests reach a remote server only once discovery matched both directions
+  *is_available =
+    NULL != custom_client->local_service ||
+    (custom_client->writer->getProxiesCount() > 0 &&
+    custom_client->reader->getProxiesCount() > 0);
+
+  return RMW_RET_OK;
+}
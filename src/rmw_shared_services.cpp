@@ -0,0 +1,179 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./rmw_shared_services.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <rmw/error_handling.h>
+
+#include "./callbacks.hpp"
+#include "./utils.hpp"
+
+#ifdef RMW_ERTPS_SHARED_PARAMETER_SERVICES
+// Services created by rcl for every node, the position in the table is the shared index
+static const char * const parameter_services[] = {
+  "describe_parameters",
+  "get_parameters",
+  "get_parameter_types",
+  "list_parameters",
+  "set_parameters",
+  "set_parameters_atomically",
+};
+
+static const char shared_topic_suffix[] = "/_parameters";
+static const char shared_request_type[] = "rmw_embeddedrtps::srv::dds_::ParameterService_Request_";
+static const char shared_reply_type[] = "rmw_embeddedrtps::srv::dds_::ParameterService_Response_";
+
+// Matches the parameter services rcl creates for the node, named after its fully
+// qualified name
+static uint8_t node_parameter_service_index(
+  const rmw_node_t * node,
+  const char * service_name)
+{
+  if (NULL == node->name || NULL == node->namespace_) {
+    return 0;
+  }
+
+  // The root namespace already ends with the separator
+  const size_t namespace_length = strlen(node->namespace_);
+  const bool root_namespace =
+    namespace_length > 0 && '/' == node->namespace_[namespace_length - 1];
+
+  char prefix[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
+  int prefix_length = snprintf(
+    prefix, sizeof(prefix), "%s%s%s/",
+    node->namespace_, root_namespace ? "" : "/", node->name);
+  if (prefix_length < 0 || static_cast<size_t>(prefix_length) >= sizeof(prefix) ||
+    0 != strncmp(service_name, prefix, static_cast<size_t>(prefix_length)))
+  {
+    return 0;
+  }
+
+  const char * short_name = service_name + prefix_length;
+  for (size_t i = 0; i < sizeof(parameter_services) / sizeof(parameter_services[0]); i++) {
+    if (0 == strcmp(short_name, parameter_services[i])) {
+      return static_cast<uint8_t>(i + 1);
+    }
+  }
+  return 0;
+}
+#endif  // RMW_ERTPS_SHARED_PARAMETER_SERVICES
+
+uint8_t rmw_ertps_shared_service_index(
+  const rmw_ertps_node_t * node,
+  const char * service_name)
+{
+#ifdef RMW_ERTPS_SHARED_PARAMETER_SERVICES
+  return node_parameter_service_index(node->rmw_handle, service_name);
+#else
+  (void) node;
+  (void) service_name;
+  return 0;
+#endif  // RMW_ERTPS_SHARED_PARAMETER_SERVICES
+}
+
+void rmw_ertps_shared_service_names(
+  const char * service_name,
+  char * request_topic,
+  char * reply_topic,
+  size_t topic_size,
+  char * request_type,
+  char * reply_type,
+  size_t type_size)
+{
+#ifdef RMW_ERTPS_SHARED_PARAMETER_SERVICES
+  // Node name followed by the common suffix, in place of the service name
+  char shared_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
+  int node_name_length = static_cast<int>(strrchr(service_name, '/') - service_name);
+  snprintf(
+    shared_name, sizeof(shared_name), "%.*s%s",
+    node_name_length, service_name, shared_topic_suffix);
+
+  generate_service_topics(shared_name, request_topic, reply_topic, topic_size);
+  snprintf(request_type, type_size, "%s", shared_request_type);
+  snprintf(reply_type, type_size, "%s", shared_reply_type);
+#else
+  (void) service_name;
+  (void) request_topic;
+  (void) reply_topic;
+  (void) topic_size;
+  (void) request_type;
+  (void) reply_type;
+  (void) type_size;
+#endif  // RMW_ERTPS_SHARED_PARAMETER_SERVICES
+}
+
+bool rmw_ertps_shared_service_endpoints(
+  rmw_ertps_node_t * node,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_policies,
+  rtps::Writer ** writer,
+  rtps::Reader ** reader)
+{
+#ifdef RMW_ERTPS_SHARED_PARAMETER_SERVICES
+  if (nullptr == node->shared_service_writer || nullptr == node->shared_service_reader) {
+    char req_type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
+    char res_type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
+    char req_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
+    char res_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
+    rmw_ertps_shared_service_names(
+      service_name,
+      req_topic_name, res_topic_name, RMW_ERTPS_TOPIC_NAME_MAX_LENGTH,
+      req_type_name, res_type_name, RMW_ERTPS_TYPE_NAME_MAX_LENGTH);
+
+    if (nullptr == node->shared_service_writer) {
+      node->shared_service_writer = node->context->domain->createWriter(
+        *node->context->participant,
+        res_topic_name,
+        res_type_name,
+        qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
+
+      if (nullptr == node->shared_service_writer) {
+        RMW_SET_ERROR_MSG("failed to create shared reply writer");
+        return false;
+      }
+    }
+
+    node->shared_service_reader = node->context->domain->createReader(
+      *node->context->participant,
+      req_topic_name,
+      req_type_name,
+      qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
+
+    if (nullptr == node->shared_service_reader) {
+      RMW_SET_ERROR_MSG("failed to create shared request reader");
+      return false;
+    }
+
+    // Only drops what other participants send, see owns_sample
+    node->shared_service_reader->registerCallback(
+      generic_callback<rmw_ertps_service_t>,
+      node->shared_service_reader);
+  }
+
+  *writer = node->shared_service_writer;
+  *reader = node->shared_service_reader;
+  return true;
+#else
+  (void) node;
+  (void) service_name;
+  (void) qos_policies;
+  (void) writer;
+  (void) reader;
+  RMW_SET_ERROR_MSG("shared parameter services not enabled");
+  return false;
+#endif  // RMW_ERTPS_SHARED_PARAMETER_SERVICES
+}
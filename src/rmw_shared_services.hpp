@@ -0,0 +1,61 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_SHARED_SERVICES_HPP_
+#define RMW_SHARED_SERVICES_HPP_
+
+#include <rtps/rtps.h>
+
+#include <rmw/types.h>
+
+#include "./types.hpp"
+
+// The parameter services of a node can share one request reader and one reply writer,
+// saving RTPS endpoints. They can then only be called by clients of the same context,
+// which bypass RTPS. No other participant can call them, whatever its RMW.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Index of a parameter service within the endpoints shared by its node, from 1. Only the
+// parameter services named after the fully qualified name of the node are shared.
+// 0 if the service has endpoints of its own, always without RMW_ERTPS_SHARED_PARAMETER_SERVICES.
+uint8_t rmw_ertps_shared_service_index(
+  const rmw_ertps_node_t * node,
+  const char * service_name);
+
+void rmw_ertps_shared_service_names(
+  const char * service_name,
+  char * request_topic,
+  char * reply_topic,
+  size_t topic_size,
+  char * request_type,
+  char * reply_type,
+  size_t type_size);
+
+// Request reader and reply writer of the node, created for its first parameter service
+bool rmw_ertps_shared_service_endpoints(
+  rmw_ertps_node_t * node,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_policies,
+  rtps::Writer ** writer,
+  rtps::Reader ** reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RMW_SHARED_SERVICES_HPP_
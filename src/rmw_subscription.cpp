@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <rmw_embeddedrtps/config.h>
+#include <rmw_embeddedrtps/priority.h>
 
 #include <rosidl_typesupport_microxrcedds_c/identifier.h>
 #include <rosidl_typesupport_microxrcedds_c/message_type_support.h>
@@ -24,6 +25,8 @@
 
 #include "./utils.hpp"
 #include "./callbacks.hpp"
+#include "./rmw_event.hpp"
+#include "./rmw_wait_set.hpp"
 
 rmw_ret_t
 rmw_init_subscription_allocation(
@@ -31,22 +34,37 @@ rmw_init_subscription_allocation(
   const rosidl_runtime_c__Sequence__bound * message_bounds,
   rmw_subscription_allocation_t * allocation)
 {
-  (void)type_support;
-  (void)message_bounds;
-  (void)allocation;
+  RMW_CHECK_ARGUMENT_FOR_NULL(type_support, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
 
-  RMW_SET_ERROR_MSG("Function not implemented");
-  return RMW_RET_UNSUPPORTED;
+  rmw_ertps_allocation_t * custom_allocation =
+    rmw_ertps_create_allocation(type_support, message_bounds);
+  if (NULL == custom_allocation) {
+    return RMW_RET_ERROR;
+  }
+
+  allocation->implementation_identifier = rmw_get_implementation_identifier();
+  allocation->data = custom_allocation;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
 rmw_fini_subscription_allocation(
   rmw_subscription_allocation_t * allocation)
 {
-  (void)allocation;
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
 
-  RMW_SET_ERROR_MSG("Function not implemented");
-  return RMW_RET_UNSUPPORTED;
+  if (!is_ertps_rmw_identifier_valid(allocation->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("allocation handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_free(allocation->data);
+  allocation->implementation_identifier = NULL;
+  allocation->data = NULL;
+
+  return RMW_RET_OK;
 }
 
 rmw_subscription_t *
@@ -57,8 +75,6 @@ rmw_create_subscription(
   const rmw_qos_profile_t * qos_policies,
   const rmw_subscription_options_t * subscription_options)
 {
-  (void)subscription_options;
-
   rmw_subscription_t * rmw_subscription = NULL;
   if (!node) {
     RMW_SET_ERROR_MSG("node handle is null");
@@ -98,7 +114,25 @@ rmw_create_subscription(
     custom_subscription->rmw_handle = rmw_subscription;
 
     custom_subscription->owner_node = custom_node;
+    custom_subscription->wait_set_mask = 0;
+    custom_subscription->input_queue.head = NULL;
+    custom_subscription->input_queue.tail = NULL;
+    custom_subscription->input_queue.count = 0;
+    custom_subscription->on_new_data = NULL;
+    custom_subscription->on_new_data_user_data = NULL;
     memcpy(&custom_subscription->qos, qos_policies, sizeof(rmw_qos_profile_t));
+    custom_subscription->ignore_local_publications =
+      NULL != subscription_options && subscription_options->ignore_local_publications;
+    custom_subscription->priority = 0;
+    rmw_ertps_events_init(custom_subscription);
+    if (NULL != subscription_options &&
+      NULL != subscription_options->rmw_specific_subscription_payload)
+    {
+      const rmw_embeddedrtps_subscription_options_t * ertps_options =
+        reinterpret_cast<const rmw_embeddedrtps_subscription_options_t *>(
+        subscription_options->rmw_specific_subscription_payload);
+      custom_subscription->priority = ertps_options->priority;
+    }
 
     const rosidl_message_type_support_t * type_support_xrce = get_message_typesupport_handle(
       type_support, ROSIDL_TYPESUPPORT_MICROXRCEDDS_C__IDENTIFIER_VALUE);
@@ -116,6 +150,8 @@ rmw_create_subscription(
       goto fail;
     }
 
+    custom_subscription->plain_size = rmw_ertps_get_plain_message_size(type_support);
+
     static char full_topic_name[RMW_ERTPS_TOPIC_NAME_MAX_LENGTH];
     static char type_name[RMW_ERTPS_TYPE_NAME_MAX_LENGTH];
 
@@ -146,6 +182,7 @@ rmw_create_subscription(
       custom_subscription->reader);
 
     rmw_subscription->data = custom_subscription;
+    rmw_ertps_match_local_subscription(custom_subscription);
   }
   return rmw_subscription;
 
@@ -191,3 +228,23 @@ rmw_destroy_subscription(
   RMW_SET_ERROR_MSG("Function not implemented");
   return RMW_RET_UNSUPPORTED;
 }
+
+rmw_ret_t
+rmw_subscription_set_on_new_message_callback(
+  rmw_subscription_t * subscription,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  if (!subscription) {
+    RMW_SET_ERROR_MSG("subscription handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(subscription->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("subscription handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_ertps_set_on_new_data_callback(
+    reinterpret_cast<rmw_ertps_subscription_t *>(subscription->data), callback, user_data);
+
+  return RMW_RET_OK;
+}
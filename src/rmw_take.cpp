@@ -15,6 +15,7 @@
 #include <rmw/rmw.h>
 #include <rmw/error_handling.h>
 
+#include "./rmw_wait_set.hpp"
 #include "./utils.hpp"
 
 rmw_ret_t
@@ -36,7 +37,6 @@ rmw_take_with_info(
   rmw_subscription_allocation_t * allocation)
 {
   (void)message_info;
-  (void)allocation;
 
   if (taken != NULL) {
     *taken = false;
@@ -50,27 +50,32 @@ rmw_take_with_info(
   rmw_ertps_subscription_t * custom_subscription =
     reinterpret_cast<rmw_ertps_subscription_t *>(subscription->data);
 
-  // Find first related item in static buffer memory pool
-  rmw_ertps_mempool_item_t * static_buffer_item = rmw_ertps_find_static_input_buffer_by_owner(
-    reinterpret_cast<void *>( custom_subscription));
+  rmw_ertps_allocation_t * custom_allocation = NULL;
+  if (NULL != allocation) {
+    if (!is_ertps_rmw_identifier_valid(allocation->implementation_identifier)) {
+      RMW_SET_ERROR_MSG("Wrong allocation implementation");
+      return RMW_RET_ERROR;
+    }
+    custom_allocation = reinterpret_cast<rmw_ertps_allocation_t *>(allocation->data);
+  }
+
+  // Claim the oldest sample, concurrent takers never get the same one
+  rmw_ertps_mempool_item_t * static_buffer_item = rmw_ertps_ready_pop(custom_subscription);
   if (static_buffer_item == NULL) {
-    return RMW_RET_ERROR;
+    return RMW_RET_OK;
   }
 
   rmw_ertps_static_input_buffer_t * static_buffer =
     reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
 
-  ucdrBuffer temp_buffer;
-  ucdr_init_buffer(
-    &temp_buffer,
-    &static_buffer->buffer[4],
-    static_buffer->length - 4);
-
-  bool deserialize_rv = custom_subscription->type_support_callbacks->cdr_deserialize(
-    &temp_buffer,
+  bool deserialize_rv = rmw_ertps_deserialize_static_input_buffer(
+    static_buffer,
+    custom_subscription->type_support_callbacks,
+    custom_subscription->plain_size,
+    custom_allocation,
     ros_message);
 
-  put_memory(&static_buffer_memory, static_buffer_item);
+  rmw_ertps_release_static_input_buffer(static_buffer_item);
 
   if (taken != NULL) {
     *taken = deserialize_rv;
@@ -206,17 +211,3 @@ rmw_return_loaned_message_from_subscription(
   RMW_SET_ERROR_MSG("Function not implemented");
   return RMW_RET_UNSUPPORTED;
 }
-
-rmw_ret_t
-rmw_take_event(
-  const rmw_events_t * event_handle,
-  void * event_info,
-  bool * taken)
-{
-  (void)event_handle;
-  (void)event_info;
-  (void)taken;
-
-  RMW_SET_ERROR_MSG("Function not implemented");
-  return RMW_RET_UNSUPPORTED;
-}
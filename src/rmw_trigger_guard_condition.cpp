@@ -13,16 +13,26 @@
 // limitations under the License.
 
 #include <rmw/rmw.h>
-#include <rmw/names_and_types.h>
 #include <rmw/error_handling.h>
 
+#include "./rmw_wait_set.hpp"
+#include "./types.hpp"
+#include "./utils.hpp"
 
 rmw_ret_t
 rmw_trigger_guard_condition(
   const rmw_guard_condition_t * guard_condition)
 {
-  (void)guard_condition;
+  if (!guard_condition) {
+    RMW_SET_ERROR_MSG("guard condition handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(guard_condition->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("guard condition handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
 
-  RMW_SET_ERROR_MSG("Function not implemented");
-  return RMW_RET_UNSUPPORTED;
+  rmw_ertps_guard_condition_trigger(
+    reinterpret_cast<rmw_ertps_guard_condition_t *>(guard_condition->data));
+
+  return RMW_RET_OK;
 }
@@ -12,18 +12,58 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <limits.h>
-#include <math.h>
+#include <rcutils/time.h>
 
 #include <rmw/rmw.h>
-#include <rmw/time.h>
 #include <rmw/error_handling.h>
+#include <rmw/time.h>
 
-#include <lwip/sys.h>
-
+#include "./rmw_batching.hpp"
+#include "./rmw_event.hpp"
+#include "./rmw_wait_set.hpp"
 #include "./utils.hpp"
+#include "./wakeup.hpp"
+
+// Guard conditions are not pooled, so they are attached only while waiting
+static void attach_guard_conditions(
+  rmw_guard_conditions_t * guard_conditions,
+  const rmw_ertps_wait_set_t * wait_set,
+  bool attach)
+{
+  for (size_t i = 0; guard_conditions && i < guard_conditions->guard_condition_count; ++i) {
+    rmw_ertps_guard_condition_t * custom_guard_condition =
+      reinterpret_cast<rmw_ertps_guard_condition_t *>(guard_conditions->guard_conditions[i]);
+    if (NULL == custom_guard_condition) {
+      continue;
+    }
+    if (attach) {
+      rmw_ertps_wait_set_attach(&custom_guard_condition->wait_set_mask, wait_set);
+    } else {
+      rmw_ertps_wait_set_detach(&custom_guard_condition->wait_set_mask, wait_set);
+    }
+  }
+}
 
-sys_sem_t rmw_wait_sem;
+// QoS events wake the wait set through their subscription, attached only while waiting
+static void attach_events(
+  rmw_events_t * events,
+  const rmw_ertps_wait_set_t * wait_set,
+  bool attach)
+{
+  for (size_t i = 0; events && i < events->event_count; ++i) {
+    rmw_event_t * event = reinterpret_cast<rmw_event_t *>(events->events[i]);
+    if (NULL == event) {
+      continue;
+    }
+    rmw_ertps_subscription_t * custom_subscription =
+      reinterpret_cast<rmw_ertps_subscription_t *>(event->data);
+    if (attach) {
+      rmw_ertps_wait_set_attach(&custom_subscription->events.wait_set_mask, wait_set);
+    } else {
+      rmw_ertps_wait_set_detach(&custom_subscription->events.wait_set_mask, wait_set);
+    }
+  }
+}
 
 rmw_ret_t
 rmw_wait(
@@ -35,113 +75,133 @@ rmw_wait(
   rmw_wait_set_t * wait_set,
   const rmw_time_t * wait_timeout)
 {
-  (void)events;
-  (void)wait_set;
-  (void)guard_conditions;
+  if (!wait_set) {
+    RMW_SET_ERROR_MSG("wait set handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  } else if (!is_ertps_rmw_identifier_valid(wait_set->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("wait set handle not from this implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+
+  rmw_ertps_wait_set_t * custom_wait_set =
+    reinterpret_cast<rmw_ertps_wait_set_t *>(wait_set->data);
+
+#ifdef RMW_ERTPS_BATCHING
+  // Samples batched during the last cycle are sent before waiting
+  for (rmw_ertps_mempool_item_t * item = session_memory.allocateditems;
+    item != NULL; item = item->next)
+  {
+    rmw_ertps_batch_flush(reinterpret_cast<rmw_context_impl_t *>(item->data));
+  }
+#endif  // RMW_ERTPS_BATCHING
+
+  // Attached before checking, so data arriving meanwhile still signals this wait set
+  rmw_ertps_wait_set_register(custom_wait_set, subscriptions, services, clients);
+  attach_guard_conditions(guard_conditions, custom_wait_set, true);
+  attach_events(events, custom_wait_set, true);
 
-  // Check if timeout
-  rmw_duration_t timeout = rmw_time_total_nsec(*wait_timeout);
+  // Signals left by samples that earlier calls already reported are stale
+  rmw_ertps_wakeup_reset(&custom_wait_set->wakeup);
 
-  // Clear data flags
   bool available_data = false;
-  for (size_t i = 0; !available_data && i < services->service_count; ++i) {
-    rmw_ertps_service_t * custom_service =
-      reinterpret_cast<rmw_ertps_service_t *>(services->services[i]);
-    if (custom_service->has_data) {
+  for (size_t i = 0; guard_conditions && i < guard_conditions->guard_condition_count; ++i) {
+    const rmw_ertps_guard_condition_t * custom_guard_condition =
+      reinterpret_cast<const rmw_ertps_guard_condition_t *>(
+      guard_conditions->guard_conditions[i]);
+    if (NULL != custom_guard_condition &&
+      rmw_ertps_guard_condition_is_triggered(custom_guard_condition))
+    {
       available_data = true;
+      break;
     }
   }
-  for (size_t i = 0; !available_data && i < clients->client_count; ++i) {
-    rmw_ertps_client_t * custom_client =
-      reinterpret_cast<rmw_ertps_client_t *>(clients->clients[i]);
-    if (custom_client->has_data) {
-      available_data = true;
+  available_data = available_data || rmw_ertps_wait_set_any_ready(custom_wait_set);
+
+  // Event deadlines bound the wait, as they have no timer to wake it
+  rcutils_time_point_value_t now;
+  rcutils_steady_time_now(&now);
+  rcutils_duration_value_t deadline_timeout = -1;
+  for (size_t i = 0; events && i < events->event_count; ++i) {
+    const rmw_event_t * event = reinterpret_cast<const rmw_event_t *>(events->events[i]);
+    if (NULL == event) {
+      continue;
     }
-  }
-  for (size_t i = 0; !available_data && i < subscriptions->subscriber_count; ++i) {
-    rmw_ertps_subscription_t * custom_subscription =
-      reinterpret_cast<rmw_ertps_subscription_t *>(subscriptions->subscribers[i]);
-    if (custom_subscription->has_data) {
-      available_data = true;
+    available_data = rmw_ertps_event_is_ready(event, now) || available_data;
+    rcutils_duration_value_t left = rmw_ertps_event_time_to_deadline(event, now);
+    if (left >= 0 && (deadline_timeout < 0 || left < deadline_timeout)) {
+      deadline_timeout = left;
     }
   }
 
-  // If there is no data and timeout is positive, wait for data
-  if (!available_data && timeout > 0) {
-    int32_t timeout_ms;
-    if (rmw_time_equal(*wait_timeout, (rmw_time_t)RMW_DURATION_INFINITE)) {
-      timeout_ms = static_cast<uint32_t>(0U);
-    } else {
-      timeout_ms = static_cast<int32_t>((timeout / 1000000ULL));
-    }
-    // Enable flag if sem wait is not timeout
-    available_data |= (SYS_ARCH_TIMEOUT != sys_arch_sem_wait(&rmw_wait_sem, timeout_ms));
+  const rmw_time_t * timeout = wait_timeout;
+  rmw_time_t bounded_timeout;
+  if (deadline_timeout >= 0 &&
+    (NULL == wait_timeout ||
+    rmw_time_equal(*wait_timeout, (rmw_time_t)RMW_DURATION_INFINITE) ||
+    deadline_timeout < rmw_time_total_nsec(*wait_timeout)))
+  {
+    bounded_timeout.sec = static_cast<uint64_t>(deadline_timeout / 1000000000LL);
+    bounded_timeout.nsec = static_cast<uint64_t>(deadline_timeout % 1000000000LL);
+    timeout = &bounded_timeout;
   }
 
-  // Determine entities with data
-  if (available_data) {
-    // Check services
-    for (size_t i = 0; i < services->service_count; ++i) {
-      rmw_ertps_service_t * custom_service =
-        reinterpret_cast<rmw_ertps_service_t *>(services->services[i]);
-
-      if (NULL !=
-        rmw_ertps_find_static_input_buffer_by_owner(reinterpret_cast<void *>(custom_service)))
-      {
-        custom_service->has_data = true;
-        available_data = true;
-      }
-    }
-
-    // Check clients
-    for (size_t i = 0; i < clients->client_count; ++i) {
-      rmw_ertps_client_t * custom_client =
-        reinterpret_cast<rmw_ertps_client_t *>(clients->clients[i]);
-
-      if (NULL !=
-        rmw_ertps_find_static_input_buffer_by_owner(reinterpret_cast<void *>(custom_client)))
-      {
-        custom_client->has_data = true;
-        available_data = true;
-      }
-    }
+  // If there is no data, wait for it unless polling
+  if (!available_data) {
+    rmw_ertps_wakeup_wait(&custom_wait_set->wakeup, timeout);
+  }
 
-    // Check subscriptions
-    for (size_t i = 0; subscriptions && i < subscriptions->subscriber_count; ++i) {
-      rmw_ertps_subscription_t * custom_subscription =
-        reinterpret_cast<rmw_ertps_subscription_t *>(subscriptions->subscribers[i]);
-
-      if (NULL !=
-        rmw_ertps_find_static_input_buffer_by_owner(reinterpret_cast<void *>(custom_subscription)))
-      {
-        custom_subscription->has_data = true;
-        available_data = true;
-      }
+  attach_guard_conditions(guard_conditions, custom_wait_set, false);
+  attach_events(events, custom_wait_set, false);
+
+  // Report and clear triggered guard conditions
+  available_data = false;
+  for (size_t i = 0; guard_conditions && i < guard_conditions->guard_condition_count; ++i) {
+    rmw_ertps_guard_condition_t * custom_guard_condition =
+      reinterpret_cast<rmw_ertps_guard_condition_t *>(guard_conditions->guard_conditions[i]);
+    if (NULL != custom_guard_condition &&
+      rmw_ertps_guard_condition_take(custom_guard_condition))
+    {
+      available_data = true;
+    } else {
+      guard_conditions->guard_conditions[i] = NULL;
     }
   }
 
-  // Set entities data flags
-  for (size_t i = 0; i < services->service_count; ++i) {
-    rmw_ertps_service_t * custom_service =
-      reinterpret_cast<rmw_ertps_service_t *>(services->services[i]);
-    if (!custom_service->has_data) {
+  // Report entities with buffered data, straight from the readiness bitmaps
+  for (size_t i = 0; services && i < services->service_count; ++i) {
+    if (rmw_ertps_is_ready(reinterpret_cast<rmw_ertps_service_t *>(services->services[i]))) {
+      available_data = true;
+    } else {
       services->services[i] = NULL;
     }
   }
-  for (size_t i = 0; i < clients->client_count; ++i) {
-    rmw_ertps_client_t * custom_client =
-      reinterpret_cast<rmw_ertps_client_t *>(clients->clients[i]);
-    if (!custom_client->has_data) {
+  for (size_t i = 0; clients && i < clients->client_count; ++i) {
+    if (rmw_ertps_is_ready(reinterpret_cast<rmw_ertps_client_t *>(clients->clients[i]))) {
+      available_data = true;
+    } else {
       clients->clients[i] = NULL;
     }
   }
-  for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
-    rmw_ertps_subscription_t * custom_subscription =
-      reinterpret_cast<rmw_ertps_subscription_t *>(subscriptions->subscribers[i]);
-    if (!custom_subscription->has_data) {
+  for (size_t i = 0; subscriptions && i < subscriptions->subscriber_count; ++i) {
+    if (rmw_ertps_is_ready(
+        reinterpret_cast<rmw_ertps_subscription_t *>(subscriptions->subscribers[i])))
+    {
+      available_data = true;
+    } else {
       subscriptions->subscribers[i] = NULL;
     }
   }
 
+  // Report events with unread status changes
+  rcutils_steady_time_now(&now);
+  for (size_t i = 0; events && i < events->event_count; ++i) {
+    const rmw_event_t * event = reinterpret_cast<const rmw_event_t *>(events->events[i]);
+    if (NULL != event && rmw_ertps_event_is_ready(event, now)) {
+      available_data = true;
+    } else {
+      events->events[i] = NULL;
+    }
+  }
+
   return (available_data) ? RMW_RET_OK : RMW_RET_TIMEOUT;
 }
@@ -0,0 +1,570 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./rmw_wait_set.hpp"
+
+#include <string.h>
+
+#include <rmw/rmw.h>
+#include <rmw/error_handling.h>
+#include <rmw/allocators.h>
+
+#include "./rmw_pending_requests.hpp"
+#include "./utils.hpp"
+
+static uint32_t wait_set_bit(
+  const rmw_ertps_wait_set_t * wait_set)
+{
+  return 1UL << static_cast<size_t>(wait_set - custom_wait_sets);
+}
+
+void rmw_ertps_wait_set_attach(
+  uint32_t * wait_set_mask,
+  const rmw_ertps_wait_set_t * wait_set)
+{
+  rtps::Lock lock{wait_set_memory.memory_mutex};
+  *wait_set_mask |= wait_set_bit(wait_set);
+}
+
+void rmw_ertps_wait_set_detach(
+  uint32_t * wait_set_mask,
+  const rmw_ertps_wait_set_t * wait_set)
+{
+  rtps::Lock lock{wait_set_memory.memory_mutex};
+  *wait_set_mask &= ~wait_set_bit(wait_set);
+}
+
+void rmw_ertps_wait_set_notify(
+  const uint32_t * wait_set_mask)
+{
+  rtps::Lock lock{wait_set_memory.memory_mutex};
+  for (size_t i = 0; i < RMW_ERTPS_MAX_WAIT_SETS; i++) {
+    if (*wait_set_mask & (1UL << i)) {
+      rmw_ertps_wakeup_signal(&custom_wait_sets[i].wakeup);
+    }
+  }
+}
+
+template<typename T>
+static void build_registration(
+  uint32_t * bitmap,
+  size_t bitmap_size,
+  void * const * entities,
+  size_t entity_count,
+  const T * pool,
+  size_t pool_size)
+{
+  memset(bitmap, 0, bitmap_size);
+  for (size_t i = 0; i < entity_count; i++) {
+    const T * entity = reinterpret_cast<const T *>(entities[i]);
+    if (NULL != entity && entity >= pool && entity < pool + pool_size) {
+      RMW_ERTPS_BITMAP_SET(bitmap, static_cast<size_t>(entity - pool));
+    }
+  }
+}
+
+template<typename T>
+static void apply_registration(
+  uint32_t * registered,
+  const uint32_t * requested,
+  size_t words,
+  T * pool,
+  uint32_t wait_set_bit)
+{
+  for (size_t w = 0; w < words; w++) {
+    const uint32_t changed = registered[w] ^ requested[w];
+    for (size_t b = 0; changed != 0 && b < 32; b++) {
+      if (changed & (1UL << b)) {
+        T * entity = &pool[w * 32 + b];
+        if (requested[w] & (1UL << b)) {
+          entity->wait_set_mask |= wait_set_bit;
+        } else {
+          entity->wait_set_mask &= ~wait_set_bit;
+        }
+      }
+    }
+    registered[w] = requested[w];
+  }
+}
+
+void rmw_ertps_wait_set_register(
+  rmw_ertps_wait_set_t * wait_set,
+  const rmw_subscriptions_t * subscriptions,
+  const rmw_services_t * services,
+  const rmw_clients_t * clients)
+{
+  uint32_t requested_subscriptions[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SUBSCRIPTIONS)];
+  uint32_t requested_services[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SERVICES)];
+  uint32_t requested_clients[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_CLIENTS)];
+
+  build_registration(
+    requested_subscriptions, sizeof(requested_subscriptions),
+    subscriptions ? subscriptions->subscribers : NULL,
+    subscriptions ? subscriptions->subscriber_count : 0,
+    custom_subscriptions, RMW_ERTPS_MAX_SUBSCRIPTIONS);
+  build_registration(
+    requested_services, sizeof(requested_services),
+    services ? services->services : NULL,
+    services ? services->service_count : 0,
+    custom_services, RMW_ERTPS_MAX_SERVICES);
+  build_registration(
+    requested_clients, sizeof(requested_clients),
+    clients ? clients->clients : NULL,
+    clients ? clients->client_count : 0,
+    custom_clients, RMW_ERTPS_MAX_CLIENTS);
+
+  // Executors usually wait on the same entities every spin
+  if (0 == memcmp(
+      requested_subscriptions, wait_set->subscriptions, sizeof(requested_subscriptions)) &&
+    0 == memcmp(requested_services, wait_set->services, sizeof(requested_services)) &&
+    0 == memcmp(requested_clients, wait_set->clients, sizeof(requested_clients)))
+  {
+    return;
+  }
+
+  rtps::Lock lock{wait_set_memory.memory_mutex};
+  const uint32_t bit = wait_set_bit(wait_set);
+  apply_registration(
+    wait_set->subscriptions, requested_subscriptions,
+    RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SUBSCRIPTIONS), custom_subscriptions, bit);
+  apply_registration(
+    wait_set->services, requested_services,
+    RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SERVICES), custom_services, bit);
+  apply_registration(
+    wait_set->clients, requested_clients,
+    RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_CLIENTS), custom_clients, bit);
+}
+
+bool rmw_ertps_wait_set_any_ready(
+  const rmw_ertps_wait_set_t * wait_set)
+{
+  rmw_context_impl_t * context = wait_set->context;
+  rtps::Lock lock{context->ready_mutex};
+  for (size_t w = 0; w < RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SUBSCRIPTIONS); w++) {
+    if (context->ready_subscriptions[w] & wait_set->subscriptions[w]) {
+      return true;
+    }
+  }
+  for (size_t w = 0; w < RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SERVICES); w++) {
+    if (context->ready_services[w] & wait_set->services[w]) {
+      return true;
+    }
+  }
+  for (size_t w = 0; w < RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_CLIENTS); w++) {
+    if (context->ready_clients[w] & wait_set->clients[w]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void rmw_ertps_guard_condition_trigger(
+  rmw_ertps_guard_condition_t * guard_condition)
+{
+  rtps::Lock lock{wait_set_memory.memory_mutex};
+  guard_condition->has_triggered = true;
+  for (size_t i = 0; i < RMW_ERTPS_MAX_WAIT_SETS; i++) {
+    if (guard_condition->wait_set_mask & (1UL << i)) {
+      rmw_ertps_wakeup_signal(&custom_wait_sets[i].wakeup);
+    }
+  }
+}
+
+bool rmw_ertps_guard_condition_is_triggered(
+  const rmw_ertps_guard_condition_t * guard_condition)
+{
+  rtps::Lock lock{wait_set_memory.memory_mutex};
+  return guard_condition->has_triggered;
+}
+
+bool rmw_ertps_guard_condition_take(
+  rmw_ertps_guard_condition_t * guard_condition)
+{
+  rtps::Lock lock{wait_set_memory.memory_mutex};
+  bool triggered = guard_condition->has_triggered;
+  guard_condition->has_triggered = false;
+  return triggered;
+}
+
+static void ready_push(
+  uint32_t * ready_bitmap,
+  size_t index,
+  rmw_ertps_input_queue_t * queue,
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
+  if (NULL == queue->tail) {
+    queue->head = static_buffer_item;
+  } else {
+    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(queue->tail->data)->next_sample =
+      static_buffer_item;
+  }
+  queue->tail = static_buffer_item;
+  queue->count++;
+
+  RMW_ERTPS_BITMAP_SET(ready_bitmap, index);
+}
+
+// Unlinks a sample from its queue, the ready_mutex must be held
+static void ready_unlink(
+  uint32_t * ready_bitmap,
+  size_t index,
+  rmw_ertps_input_queue_t * queue,
+  rmw_ertps_mempool_item_t * previous_item,
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
+  rmw_ertps_static_input_buffer_t * static_buffer =
+    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
+  if (NULL == previous_item) {
+    queue->head = static_buffer->next_sample;
+  } else {
+    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(previous_item->data)->next_sample =
+      static_buffer->next_sample;
+  }
+  if (queue->tail == static_buffer_item) {
+    queue->tail = previous_item;
+  }
+  static_buffer->next_sample = NULL;
+  queue->count--;
+
+  if (0 == queue->count) {
+    RMW_ERTPS_BITMAP_CLEAR(ready_bitmap, index);
+  }
+}
+
+// Drops the samples older than the lifespan, the ready_mutex must be held.
+// Queues are in arrival order, so expired samples are always at the head.
+// Expired responses retire the request of the client, if given.
+static bool discard_expired(
+  uint32_t * ready_bitmap,
+  size_t index,
+  rmw_ertps_input_queue_t * queue,
+  rcutils_duration_value_t lifespan,
+  rcutils_time_point_value_t now,
+  rmw_ertps_client_t * client)
+{
+  bool discarded = false;
+  while (0 != lifespan && NULL != queue->head) {
+    rmw_ertps_mempool_item_t * static_buffer_item = queue->head;
+    rmw_ertps_static_input_buffer_t * static_buffer =
+      reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
+    if (now - static_buffer->arrival_time < lifespan) {
+      break;
+    }
+    ready_unlink(ready_bitmap, index, queue, NULL, static_buffer_item);
+    if (NULL != client) {
+      rmw_ertps_pending_request_abandon(
+        client, rmw_ertps_sequence_id(static_buffer->related_sequence_number));
+    }
+    rmw_ertps_release_static_input_buffer(static_buffer_item);
+    discarded = true;
+  }
+  return discarded;
+}
+
+static rmw_ertps_mempool_item_t * ready_pop(
+  sys_mutex_t * ready_mutex,
+  uint32_t * ready_bitmap,
+  size_t index,
+  rmw_ertps_input_queue_t * queue,
+  const rcutils_duration_value_t * lifespan,
+  rmw_ertps_client_t * client)
+{
+  rcutils_time_point_value_t now;
+  rcutils_steady_time_now(&now);
+
+  rtps::Lock lock{*ready_mutex};
+
+  if (NULL != lifespan) {
+    discard_expired(ready_bitmap, index, queue, *lifespan, now, client);
+  }
+
+  rmw_ertps_mempool_item_t * static_buffer_item = queue->head;
+  if (NULL != static_buffer_item) {
+    ready_unlink(ready_bitmap, index, queue, NULL, static_buffer_item);
+  }
+
+  return static_buffer_item;
+}
+
+void rmw_ertps_ready_push(
+  rmw_ertps_subscription_t * subscription,
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
+  ready_push(
+    subscription->owner_node->context->ready_subscriptions,
+    static_cast<size_t>(subscription - custom_subscriptions),
+    &subscription->input_queue, static_buffer_item);
+}
+
+void rmw_ertps_ready_push(
+  rmw_ertps_service_t * service,
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
+  ready_push(
+    service->owner_node->context->ready_services,
+    static_cast<size_t>(service - custom_services),
+    &service->input_queue, static_buffer_item);
+}
+
+void rmw_ertps_ready_push(
+  rmw_ertps_client_t * client,
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
+  ready_push(
+    client->owner_node->context->ready_clients,
+    static_cast<size_t>(client - custom_clients),
+    &client->input_queue, static_buffer_item);
+}
+
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_subscription_t * subscription)
+{
+  rmw_context_impl_t * context = subscription->owner_node->context;
+  return ready_pop(
+    &context->ready_mutex, context->ready_subscriptions,
+    static_cast<size_t>(subscription - custom_subscriptions),
+    &subscription->input_queue, NULL, NULL);
+}
+
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_service_t * service)
+{
+  rmw_context_impl_t * context = service->owner_node->context;
+  return ready_pop(
+    &context->ready_mutex, context->ready_services,
+    static_cast<size_t>(service - custom_services),
+    &service->input_queue, &service->lifespan, NULL);
+}
+
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_client_t * client)
+{
+  rmw_context_impl_t * context = client->owner_node->context;
+  return ready_pop(
+    &context->ready_mutex, context->ready_clients,
+    static_cast<size_t>(client - custom_clients),
+    &client->input_queue, &client->lifespan, client);
+}
+
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id)
+{
+  rcutils_time_point_value_t now;
+  rcutils_steady_time_now(&now);
+
+  rmw_context_impl_t * context = client->owner_node->context;
+  rtps::Lock lock{context->ready_mutex};
+
+  discard_expired(
+    context->ready_clients, static_cast<size_t>(client - custom_clients),
+    &client->input_queue, client->lifespan, now, client);
+
+  rmw_ertps_mempool_item_t * previous_item = NULL;
+  rmw_ertps_mempool_item_t * static_buffer_item = client->input_queue.head;
+  while (NULL != static_buffer_item) {
+    rmw_ertps_static_input_buffer_t * static_buffer =
+      reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
+    if (rmw_ertps_sequence_id(static_buffer->related_sequence_number) == sequence_id) {
+      ready_unlink(
+        context->ready_clients, static_cast<size_t>(client - custom_clients),
+        &client->input_queue, previous_item, static_buffer_item);
+      break;
+    }
+    previous_item = static_buffer_item;
+    static_buffer_item = static_buffer->next_sample;
+  }
+
+  return static_buffer_item;
+}
+
+bool rmw_ertps_expire_samples(
+  rmw_context_impl_t * context)
+{
+  rcutils_time_point_value_t now;
+  rcutils_steady_time_now(&now);
+
+  // Only entities with buffered samples can hold expired ones
+  bool discarded = false;
+  for (size_t i = 0; i < RMW_ERTPS_MAX_SERVICES; i++) {
+    if (RMW_ERTPS_BITMAP_IS_SET(context->ready_services, i)) {
+      rmw_ertps_service_t * service = &custom_services[i];
+      discarded = discard_expired(
+        context->ready_services, i, &service->input_queue, service->lifespan, now, NULL) ||
+        discarded;
+    }
+  }
+  for (size_t i = 0; i < RMW_ERTPS_MAX_CLIENTS; i++) {
+    if (RMW_ERTPS_BITMAP_IS_SET(context->ready_clients, i)) {
+      rmw_ertps_client_t * client = &custom_clients[i];
+      discarded = discard_expired(
+        context->ready_clients, i, &client->input_queue, client->lifespan, now, client) ||
+        discarded;
+    }
+  }
+  return discarded;
+}
+
+template<typename T>
+static void set_on_new_data_callback(
+  T * entity,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  size_t unread_count;
+  {
+    rtps::Lock lock{entity->owner_node->context->ready_mutex};
+    entity->on_new_data = callback;
+    entity->on_new_data_user_data = user_data;
+    unread_count = entity->input_queue.count;
+  }
+
+  // Called without holding the lock, listeners may take straight away
+  if (NULL != callback && unread_count > 0) {
+    callback(user_data, unread_count);
+  }
+}
+
+void rmw_ertps_set_on_new_data_callback(
+  rmw_ertps_subscription_t * subscription,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  set_on_new_data_callback(subscription, callback, user_data);
+}
+
+void rmw_ertps_set_on_new_data_callback(
+  rmw_ertps_service_t * service,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  set_on_new_data_callback(service, callback, user_data);
+}
+
+void rmw_ertps_set_on_new_data_callback(
+  rmw_ertps_client_t * client,
+  rmw_event_callback_t callback,
+  const void * user_data)
+{
+  set_on_new_data_callback(client, callback, user_data);
+}
+
+bool rmw_ertps_is_ready(
+  const rmw_ertps_subscription_t * subscription)
+{
+  rmw_context_impl_t * context = subscription->owner_node->context;
+  rtps::Lock lock{context->ready_mutex};
+  return RMW_ERTPS_BITMAP_IS_SET(
+    context->ready_subscriptions,
+    static_cast<size_t>(subscription - custom_subscriptions));
+}
+
+bool rmw_ertps_is_ready(
+  const rmw_ertps_service_t * service)
+{
+  rmw_context_impl_t * context = service->owner_node->context;
+  rtps::Lock lock{context->ready_mutex};
+  return RMW_ERTPS_BITMAP_IS_SET(
+    context->ready_services,
+    static_cast<size_t>(service - custom_services));
+}
+
+bool rmw_ertps_is_ready(
+  const rmw_ertps_client_t * client)
+{
+  rmw_context_impl_t * context = client->owner_node->context;
+  rtps::Lock lock{context->ready_mutex};
+  return RMW_ERTPS_BITMAP_IS_SET(
+    context->ready_clients,
+    static_cast<size_t>(client - custom_clients));
+}
+
+rmw_wait_set_t *
+rmw_create_wait_set(
+  rmw_context_t * context,
+  size_t max_conditions)
+{
+  (void)max_conditions;
+
+  rmw_wait_set_t * rmw_wait_set = NULL;
+  if (!context) {
+    RMW_SET_ERROR_MSG("context handle is null");
+  } else if (!is_ertps_rmw_identifier_valid(context->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("context handle not from this implementation");
+  } else {
+    rmw_ertps_mempool_item_t * memory_node = get_memory(&wait_set_memory);
+    if (!memory_node) {
+      RMW_SET_ERROR_MSG("Not available memory node");
+      return NULL;
+    }
+
+    rmw_ertps_wait_set_t * custom_wait_set =
+      reinterpret_cast<rmw_ertps_wait_set_t *>(memory_node->data);
+
+    rmw_wait_set = reinterpret_cast<rmw_wait_set_t *>(rmw_allocate(
+        sizeof(rmw_wait_set_t)));
+    if (!rmw_wait_set) {
+      RMW_SET_ERROR_MSG("failed to allocate memory");
+      put_memory(&wait_set_memory, memory_node);
+      return NULL;
+    }
+
+    if (!rmw_ertps_wakeup_init(&custom_wait_set->wakeup)) {
+      RMW_SET_ERROR_MSG("failed to create wait set wakeup");
+      rmw_free(rmw_wait_set);
+      put_memory(&wait_set_memory, memory_node);
+      return NULL;
+    }
+
+    custom_wait_set->rmw_handle = rmw_wait_set;
+    custom_wait_set->context = context->impl;
+    memset(custom_wait_set->subscriptions, 0, sizeof(custom_wait_set->subscriptions));
+    memset(custom_wait_set->services, 0, sizeof(custom_wait_set->services));
+    memset(custom_wait_set->clients, 0, sizeof(custom_wait_set->clients));
+
+    rmw_wait_set->implementation_identifier = rmw_get_implementation_identifier();
+    rmw_wait_set->guard_conditions = NULL;
+    rmw_wait_set->data = custom_wait_set;
+  }
+
+  return rmw_wait_set;
+}
+
+rmw_ret_t
+rmw_destroy_wait_set(
+  rmw_wait_set_t * wait_set)
+{
+  if (!wait_set) {
+    RMW_SET_ERROR_MSG("wait set handle is null");
+    return RMW_RET_ERROR;
+  } else if (!is_ertps_rmw_identifier_valid(wait_set->implementation_identifier)) {
+    RMW_SET_ERROR_MSG("wait set handle not from this implementation");
+    return RMW_RET_ERROR;
+  }
+
+  rmw_ertps_wait_set_t * custom_wait_set =
+    reinterpret_cast<rmw_ertps_wait_set_t *>(wait_set->data);
+
+  if (NULL != custom_wait_set) {
+    // Detach every entity still registered
+    rmw_ertps_wait_set_register(custom_wait_set, NULL, NULL, NULL);
+    rmw_ertps_wakeup_fini(&custom_wait_set->wakeup);
+    custom_wait_set->rmw_handle = NULL;
+    put_memory(&wait_set_memory, &custom_wait_set->mem);
+  }
+
+  rmw_free(wait_set);
+
+  return RMW_RET_OK;
+}
@@ -0,0 +1,113 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_WAIT_SET_HPP_
+#define RMW_WAIT_SET_HPP_
+
+#include <rmw/types.h>
+
+#include "./types.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+void rmw_ertps_wait_set_attach(
+  uint32_t * wait_set_mask,
+  const rmw_ertps_wait_set_t * wait_set);
+
+void rmw_ertps_wait_set_detach(
+  uint32_t * wait_set_mask,
+  const rmw_ertps_wait_set_t * wait_set);
+
+void rmw_ertps_wait_set_notify(
+  const uint32_t * wait_set_mask);
+
+// Keeps entities attached between waits, only changes since the last call are applied
+void rmw_ertps_wait_set_register(
+  rmw_ertps_wait_set_t * wait_set,
+  const rmw_subscriptions_t * subscriptions,
+  const rmw_services_t * services,
+  const rmw_clients_t * clients);
+
+bool rmw_ertps_wait_set_any_ready(
+  const rmw_ertps_wait_set_t * wait_set);
+
+void rmw_ertps_guard_condition_trigger(
+  rmw_ertps_guard_condition_t * guard_condition);
+
+bool rmw_ertps_guard_condition_is_triggered(
+  const rmw_ertps_guard_condition_t * guard_condition);
+
+// Returns whether the guard condition was triggered and clears it
+bool rmw_ertps_guard_condition_take(
+  rmw_ertps_guard_condition_t * guard_condition);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Input queues and readiness tracking. The context ready_mutex must be held
+// while storing the sample and calling rmw_ertps_ready_push. rmw_ertps_ready_pop
+// hands every sample to exactly one caller, in arrival order. Clients can also
+// claim the response to a given request, leaving the others queued. Requests and
+// responses older than the lifespan of their entity are discarded when popping.
+void rmw_ertps_ready_push(
+  rmw_ertps_subscription_t * subscription,
+  rmw_ertps_mempool_item_t * static_buffer_item);
+void rmw_ertps_ready_push(
+  rmw_ertps_service_t * service,
+  rmw_ertps_mempool_item_t * static_buffer_item);
+void rmw_ertps_ready_push(
+  rmw_ertps_client_t * client,
+  rmw_ertps_mempool_item_t * static_buffer_item);
+
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_subscription_t * subscription);
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_service_t * service);
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_client_t * client);
+rmw_ertps_mempool_item_t * rmw_ertps_ready_pop(
+  rmw_ertps_client_t * client,
+  int64_t sequence_id);
+
+// Discards the requests and responses older than their lifespan, returns true if
+// any input buffer was freed. The context ready_mutex must be held.
+bool rmw_ertps_expire_samples(
+  rmw_context_impl_t * context);
+
+// Listener callbacks, invoked at once with the samples already buffered
+void rmw_ertps_set_on_new_data_callback(
+  rmw_ertps_subscription_t * subscription,
+  rmw_event_callback_t callback,
+  const void * user_data);
+void rmw_ertps_set_on_new_data_callback(
+  rmw_ertps_service_t * service,
+  rmw_event_callback_t callback,
+  const void * user_data);
+void rmw_ertps_set_on_new_data_callback(
+  rmw_ertps_client_t * client,
+  rmw_event_callback_t callback,
+  const void * user_data);
+
+bool rmw_ertps_is_ready(
+  const rmw_ertps_subscription_t * subscription);
+bool rmw_ertps_is_ready(
+  const rmw_ertps_service_t * service);
+bool rmw_ertps_is_ready(
+  const rmw_ertps_client_t * client);
+
+#endif  // RMW_WAIT_SET_HPP_
@@ -14,6 +14,10 @@
 
 #include "./types.hpp"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include <rosidl_typesupport_microxrcedds_c/identifier.h>
 
 #include <rmw/allocators.h>
@@ -44,6 +48,9 @@ rmw_ertps_client_t custom_clients[RMW_ERTPS_MAX_CLIENTS];
 rmw_ertps_mempool_t static_buffer_memory;
 rmw_ertps_static_input_buffer_t custom_static_buffers[RMW_ERTPS_MAX_HISTORY];
 
+rmw_ertps_mempool_t wait_set_memory;
+rmw_ertps_wait_set_t custom_wait_sets[RMW_ERTPS_MAX_WAIT_SETS];
+
 // Memory init functions
 
 #define RMW_INIT_MEMORY(X) \
@@ -76,20 +83,96 @@ RMW_INIT_MEMORY(subscription)
 RMW_INIT_MEMORY(node)
 RMW_INIT_MEMORY(session)
 RMW_INIT_MEMORY(static_input_buffer)
-
-rmw_ertps_mempool_item_t * rmw_ertps_find_static_input_buffer_by_owner(
+RMW_INIT_MEMORY(wait_set)
+
+rmw_ertps_mempool_item_t * rmw_ertps_store_static_input_buffer(
+  const uint8_t * data,
+  size_t length,
+  const rtps::Guid_t & writer_guid,
+  const rtps::SequenceNumber_t & sequence_number,
+  const rtps::Guid_t & related_writer_guid,
+  const rtps::SequenceNumber_t & related_sequence_number,
   void * owner)
 {
-  rtps::Lock lock{static_buffer_memory.memory_mutex};
+  // A single large sample must not take the buffers of every other entity
+  const size_t fragment_capacity = RMW_ERTPS_MAX_INPUT_BUFFER_SIZE - RMW_ERTPS_FRAGMENT_HEADROOM;
+  size_t buffer_count = 1;
+  if (length > RMW_ERTPS_MAX_INPUT_BUFFER_SIZE) {
+    buffer_count +=
+      (length - RMW_ERTPS_MAX_INPUT_BUFFER_SIZE + fragment_capacity - 1) / fragment_capacity;
+  }
+  if (buffer_count > RMW_ERTPS_MAX_INPUT_BUFFERS_PER_SAMPLE) {
+    RMW_SET_ERROR_MSG("sample exceeds RMW_ERTPS_MAX_INPUT_BUFFERS_PER_SAMPLE");
+    return NULL;
+  }
+
+  rmw_ertps_mempool_item_t * static_buffer_item = get_memory(&static_buffer_memory);
+  if (!static_buffer_item) {
+    RMW_SET_ERROR_MSG("Not available static buffer memory node");
+    return NULL;
+  }
+
+  rmw_ertps_static_input_buffer_t * static_buffer =
+    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
+  static_buffer->owner = NULL;
+  static_buffer->next_fragment = NULL;
+  static_buffer->next_sample = NULL;
+  static_buffer->length = length;
+  static_buffer->writer_guid = writer_guid;
+  static_buffer->sequence_number = sequence_number;
+  static_buffer->related_writer_guid = related_writer_guid;
+  static_buffer->related_sequence_number = related_sequence_number;
+  rcutils_steady_time_now(&static_buffer->arrival_time);
+
+  // Samples larger than a single static buffer are reassembled across as many as needed
+  size_t copied = std::min(length, static_cast<size_t>(RMW_ERTPS_MAX_INPUT_BUFFER_SIZE));
+  memcpy(static_buffer->buffer, data, copied);
+  static_buffer->fragment_length = copied;
+
+  rmw_ertps_static_input_buffer_t * last_fragment = static_buffer;
+  while (copied < length) {
+    rmw_ertps_mempool_item_t * fragment_item = get_memory(&static_buffer_memory);
+    if (!fragment_item) {
+      RMW_SET_ERROR_MSG("Not available static buffer memory node for fragment");
+      rmw_ertps_release_static_input_buffer(static_buffer_item);
+      return NULL;
+    }
 
-  rmw_ertps_mempool_item_t * static_buffer_item = static_buffer_memory.allocateditems;
+    rmw_ertps_static_input_buffer_t * fragment =
+      reinterpret_cast<rmw_ertps_static_input_buffer_t *>(fragment_item->data);
+    fragment->owner = NULL;
+    fragment->next_fragment = NULL;
+    fragment->next_sample = NULL;
+    fragment->length = 0;
+    fragment->fragment_length = std::min(
+      length - copied,
+      static_cast<size_t>(RMW_ERTPS_MAX_INPUT_BUFFER_SIZE - RMW_ERTPS_FRAGMENT_HEADROOM));
+    memcpy(
+      &fragment->buffer[RMW_ERTPS_FRAGMENT_HEADROOM], &data[copied],
+      fragment->fragment_length);
+    copied += fragment->fragment_length;
+
+    last_fragment->next_fragment = fragment_item;
+    last_fragment = fragment;
+  }
+
+  static_buffer->owner = owner;
+
+  return static_buffer_item;
+}
+
+void rmw_ertps_release_static_input_buffer(
+  rmw_ertps_mempool_item_t * static_buffer_item)
+{
   while (static_buffer_item != NULL) {
-    rmw_ertps_static_input_buffer_t * data =
+    rmw_ertps_static_input_buffer_t * static_buffer =
       reinterpret_cast<rmw_ertps_static_input_buffer_t *>(static_buffer_item->data);
-    if (data->owner == owner) {
-      return static_buffer_item;
-    }
-    static_buffer_item = static_buffer_item->next;
+    rmw_ertps_mempool_item_t * next_fragment = static_buffer->next_fragment;
+
+    static_buffer->owner = NULL;
+    static_buffer->next_fragment = NULL;
+    put_memory(&static_buffer_memory, static_buffer_item);
+
+    static_buffer_item = next_fragment;
   }
-  return NULL;
 }
@@ -20,6 +20,7 @@
 
 #include <stddef.h>
 
+#include <rcutils/time.h>
 #include <rmw/types.h>
 #include <ucdr/microcdr.h>
 
@@ -33,9 +34,48 @@
 #include <rmw/error_handling.h>
 
 #include "./memory.hpp"
+#include "./wakeup.hpp"
 
 extern "C" {
 
+// Bitmaps indexed by position in the static entity pools
+#define RMW_ERTPS_BITMAP_WORDS(X) (((X) + 31) / 32)
+#define RMW_ERTPS_BITMAP_SET(B, I) ((B)[(I) / 32] |= (1UL << ((I) % 32)))
+#define RMW_ERTPS_BITMAP_CLEAR(B, I) ((B)[(I) / 32] &= ~(1UL << ((I) % 32)))
+#define RMW_ERTPS_BITMAP_IS_SET(B, I) (0 != ((B)[(I) / 32] & (1UL << ((I) % 32))))
+
+#ifdef RMW_ERTPS_BATCHING
+typedef struct rmw_ertps_batched_change_t
+{
+  rtps::Writer * writer;
+  size_t offset;
+  size_t length;
+} rmw_ertps_batched_change_t;
+
+typedef struct rmw_ertps_batch_t
+{
+  sys_mutex_t mutex;
+
+  bool enabled;
+  size_t max_bytes;
+  rmw_duration_t max_latency;
+  rcutils_time_point_value_t first_change_timestamp;
+
+  size_t used;
+  size_t change_count;
+  rmw_ertps_batched_change_t changes[RMW_ERTPS_MAX_BATCH_CHANGES];
+  uint8_t buffer[RMW_ERTPS_MAX_BATCH_SIZE];
+} rmw_ertps_batch_t;
+#endif  // RMW_ERTPS_BATCHING
+
+typedef struct rmw_ertps_guard_condition_t
+{
+  bool has_triggered;
+
+  // Wait sets currently waiting on this guard condition
+  uint32_t wait_set_mask;
+} rmw_ertps_guard_condition_t;
+
 typedef struct rmw_context_impl_t
 {
   rmw_ertps_mempool_item_t mem;
@@ -44,6 +84,18 @@ typedef struct rmw_context_impl_t
   rtps::Participant * participant;
 
   rmw_guard_condition_t graph_guard_condition;
+  rmw_ertps_guard_condition_t graph_guard_condition_data;
+
+  // Entities of this context holding buffered samples, indexed by position in their pool.
+  // The bitmaps are guarded by ready_mutex, like the samples themselves.
+  sys_mutex_t ready_mutex;
+  uint32_t ready_subscriptions[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SUBSCRIPTIONS)];
+  uint32_t ready_services[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SERVICES)];
+  uint32_t ready_clients[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_CLIENTS)];
+
+#ifdef RMW_ERTPS_BATCHING
+  rmw_ertps_batch_t batch;
+#endif  // RMW_ERTPS_BATCHING
 
 #ifdef RMW_ERTPS_GRAPH
   rtps::Writer * graph_writer;
@@ -60,6 +112,32 @@ typedef struct rmw_context_impl_t rmw_ertps_session_t;
 
 // ROS2 entities definitions
 
+#if RMW_ERTPS_MAX_WAIT_SETS > 32
+#error "RMW_ERTPS_MAX_WAIT_SETS must fit in the 32 bit entity wait set masks"
+#endif
+
+// FIFO of the static input buffers received by an entity
+typedef struct rmw_ertps_input_queue_t
+{
+  rmw_ertps_mempool_item_t * head;
+  rmw_ertps_mempool_item_t * tail;
+  size_t count;
+} rmw_ertps_input_queue_t;
+
+typedef struct rmw_ertps_wait_set_t
+{
+  rmw_ertps_mempool_item_t mem;
+  rmw_wait_set_t * rmw_handle;
+
+  rmw_context_impl_t * context;
+  rmw_ertps_wakeup_t wakeup;
+
+  // Entities attached to this wait set, indexed by position in their pool
+  uint32_t subscriptions[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SUBSCRIPTIONS)];
+  uint32_t services[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SERVICES)];
+  uint32_t clients[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_CLIENTS)];
+} rmw_ertps_wait_set_t;
+
 typedef struct rmw_ertps_service_t
 {
   rmw_ertps_mempool_item_t mem;
@@ -74,9 +152,29 @@ typedef struct rmw_ertps_service_t
 
   struct rmw_ertps_node_t * owner_node;
 
-  bool has_data;
+  // Wait sets currently waiting on this entity
+  uint32_t wait_set_mask;
+  // Samples stored in the static input buffers, guarded by the context ready_mutex
+  rmw_ertps_input_queue_t input_queue;
+  rmw_event_callback_t on_new_data;
+  const void * on_new_data_user_data;
+  uint8_t priority;
+
+  // Index within the endpoints shared by the node parameter services, 0 if not shared
+  uint8_t shared_index;
+
+  // Age in nanoseconds after which buffered requests are discarded, 0 for no limit.
+  // Guarded by the context ready_mutex.
+  rcutils_duration_value_t lifespan;
 } rmw_ertps_service_t;
 
+typedef struct rmw_ertps_pending_request_t
+{
+  int64_t sequence_id;
+  rcutils_time_point_value_t send_time;
+  bool in_use;
+} rmw_ertps_pending_request_t;
+
 typedef struct rmw_ertps_client_t
 {
   rmw_ertps_mempool_item_t mem;
@@ -91,22 +189,86 @@ typedef struct rmw_ertps_client_t
 
   struct rmw_ertps_node_t * owner_node;
 
-  bool has_data;
+  // Wait sets currently waiting on this entity
+  uint32_t wait_set_mask;
+  // Samples stored in the static input buffers, guarded by the context ready_mutex
+  rmw_ertps_input_queue_t input_queue;
+  rmw_event_callback_t on_new_data;
+  const void * on_new_data_user_data;
+  uint8_t priority;
+
+  // Age in nanoseconds after which buffered responses are discarded, 0 for no limit.
+  // Guarded by the context ready_mutex.
+  rcutils_duration_value_t lifespan;
+
+  // Service of the same context, requests are also handed to it directly
+  rmw_ertps_service_t * local_service;
+  // Last id of the requests only handed to the local service, guarded by request_mutex
+  int64_t local_sequence_id;
+
+  // Held from sending a request until it is recorded, so a fast response is not
+  // taken as unknown
+  sys_mutex_t request_mutex;
+
+  // In-flight requests, in any free slot, guarded by the context ready_mutex
+  rmw_ertps_pending_request_t pending_requests[RMW_ERTPS_MAX_PENDING_REQUESTS];
+  size_t abandoned_requests;
+
+  // Round trip latency of completed requests, in nanoseconds
+  rcutils_duration_value_t latency_last;
+  rcutils_duration_value_t latency_min;
+  rcutils_duration_value_t latency_max;
+  rcutils_duration_value_t latency_sum;
+  size_t latency_count;
 } rmw_ertps_client_t;
 
+// QoS event state of a subscription, guarded by the context ready_mutex
+typedef struct rmw_ertps_subscription_events_t
+{
+  // Wait sets currently waiting on any event of the subscription
+  uint32_t wait_set_mask;
+
+  size_t message_lost_total;
+  size_t message_lost_change;
+  rmw_event_callback_t message_lost_callback;
+  const void * message_lost_user_data;
+
+  // Requested deadline in nanoseconds, 0 if disabled
+  rcutils_duration_value_t deadline;
+  rcutils_time_point_value_t deadline_reference;
+  int32_t deadline_missed_total;
+  int32_t deadline_missed_change;
+  // Missed periods found when a sample arrived, not yet handed to the listener
+  int32_t deadline_missed_unnotified;
+  rmw_event_callback_t deadline_missed_callback;
+  const void * deadline_missed_user_data;
+} rmw_ertps_subscription_events_t;
+
 typedef struct rmw_ertps_subscription_t
 {
   rmw_ertps_mempool_item_t mem;
   rmw_subscription_t * rmw_handle;
 
   const message_type_support_callbacks_t * type_support_callbacks;
+  // Size of the type if its CDR layout matches the in-memory one, 0 otherwise
+  size_t plain_size;
 
   rmw_qos_profile_t qos;
 
   rtps::Reader * reader;
+  bool ignore_local_publications;
+
+  rmw_ertps_subscription_events_t events;
 
   struct rmw_ertps_node_t * owner_node;
-  bool has_data;
+
+  // Wait sets currently waiting on this entity
+  uint32_t wait_set_mask;
+  // Samples stored in the static input buffers, guarded by the context ready_mutex
+  rmw_ertps_input_queue_t input_queue;
+  rmw_event_callback_t on_new_data;
+  const void * on_new_data_user_data;
+  uint8_t priority;
 } rmw_ertps_subscription_t;
 
 typedef struct rmw_ertps_publisher_t
@@ -115,11 +277,16 @@ typedef struct rmw_ertps_publisher_t
   rmw_publisher_t * rmw_handle;
 
   const message_type_support_callbacks_t * type_support_callbacks;
+  // Size of the type if its CDR layout matches the in-memory one, 0 otherwise
+  size_t plain_size;
 
   rmw_qos_profile_t qos;
 
   rtps::Writer * writer;
 
+  // Subscriptions of the same context served without going through RTPS
+  uint32_t local_subscriptions[RMW_ERTPS_BITMAP_WORDS(RMW_ERTPS_MAX_SUBSCRIPTIONS)];
+
   struct rmw_ertps_node_t * owner_node;
 } rmw_ertps_publisher_t;
 
@@ -128,6 +295,10 @@ typedef struct rmw_ertps_node_t
   rmw_ertps_mempool_item_t mem;
   rmw_node_t * rmw_handle;
   rmw_context_impl_t * context;
+
+  // Endpoints shared by the parameter services of the node, see rmw_shared_services.hpp
+  rtps::Writer * shared_service_writer;
+  rtps::Reader * shared_service_reader;
 } rmw_ertps_node_t;
 
 typedef struct rmw_ertps_static_input_buffer_t
@@ -138,13 +309,35 @@ typedef struct rmw_ertps_static_input_buffer_t
   size_t length;
   void * owner;
 
+  // Samples larger than RMW_ERTPS_MAX_INPUT_BUFFER_SIZE are chained across several buffers
+  size_t fragment_length;
+  rmw_ertps_mempool_item_t * next_fragment;
+
+  // Next sample in the owner input queue
+  rmw_ertps_mempool_item_t * next_sample;
+
   rtps::Guid_t writer_guid;
   rtps::SequenceNumber_t sequence_number;
 
   rtps::Guid_t related_writer_guid;
   rtps::SequenceNumber_t related_sequence_number;
+
+  // Steady clock reception time
+  rcutils_time_point_value_t arrival_time;
 } rmw_ertps_static_input_buffer_t;
 
+// Publisher and subscription allocations
+
+typedef struct rmw_ertps_allocation_t
+{
+  uint8_t * buffer;
+  size_t size;
+} rmw_ertps_allocation_t;
+
+// Free bytes kept in front of every fragment but the first one, used to stitch
+// primitives split between two fragments while deserializing
+#define RMW_ERTPS_FRAGMENT_HEADROOM 8
+
 // Static memory pools
 
 extern rmw_ertps_mempool_t session_memory;
@@ -168,6 +361,9 @@ extern rmw_ertps_client_t custom_clients[RMW_ERTPS_MAX_CLIENTS];
 extern rmw_ertps_mempool_t static_buffer_memory;
 extern rmw_ertps_static_input_buffer_t custom_static_buffers[RMW_ERTPS_MAX_HISTORY];
 
+extern rmw_ertps_mempool_t wait_set_memory;
+extern rmw_ertps_wait_set_t custom_wait_sets[RMW_ERTPS_MAX_WAIT_SETS];
+
 // Memory init functions
 
 #define RMW_INIT_DEFINE_MEMORY(X) \
@@ -183,11 +379,21 @@ RMW_INIT_DEFINE_MEMORY(subscription)
 RMW_INIT_DEFINE_MEMORY(node)
 RMW_INIT_DEFINE_MEMORY(session)
 RMW_INIT_DEFINE_MEMORY(static_input_buffer)
+RMW_INIT_DEFINE_MEMORY(wait_set)
 
 // Memory management functions
-rmw_ertps_mempool_item_t * rmw_ertps_find_static_input_buffer_by_owner(
+rmw_ertps_mempool_item_t * rmw_ertps_store_static_input_buffer(
+  const uint8_t * data,
+  size_t length,
+  const rtps::Guid_t & writer_guid,
+  const rtps::SequenceNumber_t & sequence_number,
+  const rtps::Guid_t & related_writer_guid,
+  const rtps::SequenceNumber_t & related_sequence_number,
   void * owner);
 
+void rmw_ertps_release_static_input_buffer(
+  rmw_ertps_mempool_item_t * static_buffer_item);
+
 }
 
 #endif  // TYPES_HPP_
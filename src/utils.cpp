@@ -14,7 +14,17 @@
 
 #include "./utils.hpp"
 
+#include <string.h>
+
+#include <limits>
+
+#include <rmw/allocators.h>
 #include <rmw/error_handling.h>
+#include <rmw/time.h>
+
+#include <rosidl_typesupport_introspection_c/field_types.h>
+#include <rosidl_typesupport_introspection_c/identifier.h>
+#include <rosidl_typesupport_introspection_c/message_introspection.h>
 
 #include "./types.hpp"
 
@@ -117,3 +127,502 @@ bool is_ertps_rmw_identifier_valid(
   return id != NULL &&
          strcmp(id, rmw_get_implementation_identifier()) == 0;
 }
+
+// Request ids carry the 12 byte prefix followed by the 4 byte entity id
+void rmw_ertps_guid_to_writer_guid(
+  const rtps::Guid_t & guid,
+  int8_t writer_guid[16])
+{
+  memcpy(writer_guid, guid.prefix.id.data(), 12);
+  memcpy(&writer_guid[12], guid.entityId.entityKey.data(), 3);
+  writer_guid[15] = static_cast<int8_t>(guid.entityId.entityKind);
+}
+
+void rmw_ertps_writer_guid_to_guid(
+  const int8_t writer_guid[16],
+  rtps::Guid_t & guid)
+{
+  memcpy(guid.prefix.id.data(), writer_guid, 12);
+  memcpy(guid.entityId.entityKey.data(), &writer_guid[12], 3);
+  guid.entityId.entityKind =
+    static_cast<rtps::EntityKind_t>(static_cast<uint8_t>(writer_guid[15]));
+}
+
+static void write_encapsulation(
+  uint8_t * buffer)
+{
+  // CDR little endian, no options
+  buffer[0] = 0;
+  buffer[1] = 1;
+  buffer[2] = 0;
+  buffer[3] = 0;
+}
+
+static bool is_local_match(
+  const rmw_ertps_publisher_t * publisher,
+  const rmw_ertps_subscription_t * subscription)
+{
+  return publisher->owner_node->context == subscription->owner_node->context &&
+         publisher->type_support_callbacks == subscription->type_support_callbacks &&
+         !subscription->ignore_local_publications &&
+         // Same rule RTPS applies to remote endpoints
+         !(publisher->qos.reliability == RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT &&
+         subscription->qos.reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT) &&
+         0 == strcmp(publisher->rmw_handle->topic_name, subscription->rmw_handle->topic_name);
+}
+
+void rmw_ertps_match_local_publisher(
+  rmw_ertps_publisher_t * publisher)
+{
+  memset(publisher->local_subscriptions, 0, sizeof(publisher->local_subscriptions));
+
+  rtps::Lock lock{subscription_memory.memory_mutex};
+
+  for (size_t i = 0; i < RMW_ERTPS_MAX_SUBSCRIPTIONS; i++) {
+    rmw_ertps_subscription_t * subscription = &custom_subscriptions[i];
+    if (NULL != subscription->rmw_handle &&
+      subscription->rmw_handle->data == subscription &&
+      is_local_match(publisher, subscription))
+    {
+      RMW_ERTPS_BITMAP_SET(publisher->local_subscriptions, i);
+    }
+  }
+}
+
+void rmw_ertps_match_local_subscription(
+  rmw_ertps_subscription_t * subscription)
+{
+  size_t index = static_cast<size_t>(subscription - custom_subscriptions);
+  if (index >= RMW_ERTPS_MAX_SUBSCRIPTIONS) {
+    // Out of the static pool, only reachable through RTPS
+    return;
+  }
+
+  rtps::Lock lock{publisher_memory.memory_mutex};
+
+  rmw_ertps_mempool_item_t * item = publisher_memory.allocateditems;
+  while (item != NULL) {
+    rmw_ertps_publisher_t * publisher = reinterpret_cast<rmw_ertps_publisher_t *>(item->data);
+    if (NULL != publisher->rmw_handle &&
+      publisher->rmw_handle->data == publisher &&
+      is_local_match(publisher, subscription))
+    {
+      RMW_ERTPS_BITMAP_SET(publisher->local_subscriptions, index);
+    }
+    item = item->next;
+  }
+}
+
+rcutils_duration_value_t rmw_ertps_lifespan_nsec(
+  rmw_time_t lifespan)
+{
+  // The default lifespan is zero, which DDS treats as infinite too
+  if (rmw_time_equal(lifespan, (rmw_time_t)RMW_DURATION_INFINITE)) {
+    return 0;
+  }
+  return rmw_time_total_nsec(lifespan);
+}
+
+rtps::Reader * rmw_ertps_find_reply_reader(
+  const rmw_ertps_client_t * client,
+  const char * reply_topic,
+  const char * reply_type)
+{
+  const bool reliable = client->qos.reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT;
+
+  rtps::Lock lock{client_memory.memory_mutex};
+
+  rmw_ertps_mempool_item_t * item = client_memory.allocateditems;
+  while (item != NULL) {
+    rmw_ertps_client_t * other = reinterpret_cast<rmw_ertps_client_t *>(item->data);
+    if (other != client &&
+      NULL != other->rmw_handle &&
+      other->rmw_handle->data == other &&
+      other->owner_node->context == client->owner_node->context &&
+      (other->qos.reliability != RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT) == reliable &&
+      0 == strcmp(other->reader->m_attributes.topicName, reply_topic) &&
+      0 == strcmp(other->reader->m_attributes.typeName, reply_type))
+    {
+      return other->reader;
+    }
+    item = item->next;
+  }
+
+  return nullptr;
+}
+
+static bool is_local_service_match(
+  const rmw_ertps_client_t * client,
+  const rmw_ertps_service_t * service)
+{
+  return client->owner_node->context == service->owner_node->context &&
+         client->type_support_callbacks == service->type_support_callbacks &&
+         0 == strcmp(client->rmw_handle->service_name, service->rmw_handle->service_name);
+}
+
+void rmw_ertps_match_local_client(
+  rmw_ertps_client_t * client)
+{
+  client->local_service = NULL;
+
+  rtps::Lock lock{service_memory.memory_mutex};
+
+  rmw_ertps_mempool_item_t * item = service_memory.allocateditems;
+  while (item != NULL) {
+    rmw_ertps_service_t * service = reinterpret_cast<rmw_ertps_service_t *>(item->data);
+    if (NULL != service->rmw_handle &&
+      service->rmw_handle->data == service &&
+      is_local_service_match(client, service))
+    {
+      client->local_service = service;
+      return;
+    }
+    item = item->next;
+  }
+}
+
+void rmw_ertps_match_local_service(
+  rmw_ertps_service_t * service)
+{
+  rtps::Lock lock{client_memory.memory_mutex};
+
+  rmw_ertps_mempool_item_t * item = client_memory.allocateditems;
+  while (item != NULL) {
+    rmw_ertps_client_t * client = reinterpret_cast<rmw_ertps_client_t *>(item->data);
+    // Clients already served locally keep their service
+    if (NULL != client->rmw_handle &&
+      client->rmw_handle->data == client &&
+      NULL == client->local_service &&
+      is_local_service_match(client, service))
+    {
+      client->local_service = service;
+    }
+    item = item->next;
+  }
+}
+
+static size_t get_primitive_size(
+  uint8_t type_id)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      return (sizeof(bool) == 1) ? 1 : 0;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return 1;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return 2;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return 4;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return 8;
+    default:
+      // Strings, wide chars and long doubles have no fixed CDR representation
+      return 0;
+  }
+}
+
+static bool check_plain_layout(
+  const rosidl_typesupport_introspection_c__MessageMembers * members,
+  size_t base_offset,
+  size_t * cdr_offset)
+{
+  for (uint32_t i = 0; i < members->member_count_; i++) {
+    const rosidl_typesupport_introspection_c__MessageMember * member = &members->members_[i];
+
+    if (member->is_array_ && (0 == member->array_size_ || member->is_upper_bound_)) {
+      // Sequences are stored out of line
+      return false;
+    }
+
+    size_t count = member->is_array_ ? member->array_size_ : 1;
+    size_t member_offset = base_offset + member->offset_;
+
+    if (rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE == member->type_id_) {
+      const rosidl_typesupport_introspection_c__MessageMembers * nested =
+        reinterpret_cast<const rosidl_typesupport_introspection_c__MessageMembers *>(
+        member->members_->data);
+      for (size_t j = 0; j < count; j++) {
+        if (!check_plain_layout(nested, member_offset + j * nested->size_of_, cdr_offset)) {
+          return false;
+        }
+      }
+    } else {
+      size_t size = get_primitive_size(member->type_id_);
+      if (0 == size) {
+        return false;
+      }
+
+      *cdr_offset += ucdr_alignment(*cdr_offset, size);
+      if (*cdr_offset != member_offset) {
+        return false;
+      }
+      *cdr_offset += size * count;
+    }
+  }
+
+  return true;
+}
+
+size_t rmw_ertps_get_plain_message_size(
+  const rosidl_message_type_support_t * type_support)
+{
+  if (UCDR_MACHINE_ENDIANNESS != UCDR_LITTLE_ENDIANNESS) {
+    // Outgoing samples are always encapsulated as little endian CDR
+    return 0;
+  }
+
+  const rosidl_message_type_support_t * type_support_introspection =
+    get_message_typesupport_handle(type_support, rosidl_typesupport_introspection_c__identifier);
+  if (NULL == type_support_introspection) {
+    // Introspection is optional, types without it use the generic path
+    rmw_reset_error();
+    return 0;
+  }
+
+  const rosidl_typesupport_introspection_c__MessageMembers * members =
+    reinterpret_cast<const rosidl_typesupport_introspection_c__MessageMembers *>(
+    type_support_introspection->data);
+
+  size_t cdr_size = 0;
+  if (!check_plain_layout(members, 0, &cdr_size)) {
+    return 0;
+  }
+
+  return cdr_size;
+}
+
+rmw_ertps_allocation_t * rmw_ertps_create_allocation(
+  const rosidl_message_type_support_t * type_support,
+  const rosidl_runtime_c__Sequence__bound * message_bounds)
+{
+  size_t size;
+  if (RMW_RET_OK != rmw_get_serialized_message_size(type_support, message_bounds, &size)) {
+    return NULL;
+  }
+
+  // Buffer is placed right after the allocation descriptor
+  rmw_ertps_allocation_t * allocation = reinterpret_cast<rmw_ertps_allocation_t *>(
+    rmw_allocate(sizeof(rmw_ertps_allocation_t) + size));
+  if (NULL == allocation) {
+    RMW_SET_ERROR_MSG("failed to allocate memory");
+    return NULL;
+  }
+
+  allocation->buffer = reinterpret_cast<uint8_t *>(allocation + 1);
+  allocation->size = size;
+
+  return allocation;
+}
+
+static bool serialize_into(
+  const message_type_support_callbacks_t * functions,
+  const void * ros_message,
+  uint8_t * buffer,
+  size_t buffer_size,
+  size_t * length)
+{
+  write_encapsulation(buffer);
+
+  ucdrBuffer mb;
+  ucdr_init_buffer(&mb, &buffer[4], buffer_size - 4);
+
+  bool written = functions->cdr_serialize(ros_message, &mb);
+  *length = ucdr_buffer_length(&mb) + 4;
+
+  return written;
+}
+
+uint8_t * rmw_ertps_serialize_message(
+  const message_type_support_callbacks_t * functions,
+  const void * ros_message,
+  size_t plain_size,
+  uint8_t * static_buffer,
+  size_t static_buffer_size,
+  size_t * length)
+{
+  uint8_t * buffer = static_buffer;
+
+  if (plain_size > 0 && plain_size + 4 <= static_buffer_size) {
+    // CDR layout matches the in-memory one
+    write_encapsulation(buffer);
+    memcpy(&buffer[4], ros_message, plain_size);
+    *length = plain_size + 4;
+    return buffer;
+  }
+
+  // Most messages fit, so they are only sized when the static buffer overflows
+  if (!serialize_into(functions, ros_message, buffer, static_buffer_size, length)) {
+#ifdef RMW_ERTPS_ALLOW_DYNAMIC_ALLOCATIONS
+    // embeddedRTPS sends them as a single DATA submessage fragmented at IP level
+    size_t required_size = functions->get_serialized_size(ros_message) + 4;
+    if (required_size <= static_buffer_size) {
+      RMW_SET_ERROR_MSG("error serializing message");
+      return NULL;
+    }
+    buffer = reinterpret_cast<uint8_t *>(rmw_allocate(required_size));
+    if (NULL == buffer) {
+      RMW_SET_ERROR_MSG("failed to allocate large message buffer");
+      return NULL;
+    }
+    if (!serialize_into(functions, ros_message, buffer, required_size, length)) {
+      RMW_SET_ERROR_MSG("error serializing message");
+      rmw_ertps_release_output_buffer(buffer, static_buffer);
+      return NULL;
+    }
+#else
+    RMW_SET_ERROR_MSG("serialized message exceeds RMW_ERTPS_MAX_OUTPUT_BUFFER_SIZE");
+    return NULL;
+#endif  // RMW_ERTPS_ALLOW_DYNAMIC_ALLOCATIONS
+  }
+
+  if (*length > std::numeric_limits<rtps::DataSize_t>::max()) {
+    RMW_SET_ERROR_MSG("serialized message exceeds maximum RTPS sample size");
+    rmw_ertps_release_output_buffer(buffer, static_buffer);
+    return NULL;
+  }
+
+  return buffer;
+}
+
+void rmw_ertps_release_output_buffer(
+  uint8_t * buffer,
+  const uint8_t * static_buffer)
+{
+  if (buffer != static_buffer) {
+    rmw_free(buffer);
+  }
+}
+
+typedef struct rmw_ertps_fragment_cursor_t
+{
+  rmw_ertps_static_input_buffer_t * fragment;
+  // Serialization offset matching the end of the current fragment
+  size_t end_offset;
+} rmw_ertps_fragment_cursor_t;
+
+static bool on_full_input_fragment(
+  ucdrBuffer * ub,
+  void * args)
+{
+  rmw_ertps_fragment_cursor_t * cursor = reinterpret_cast<rmw_ertps_fragment_cursor_t *>(args);
+  if (NULL == cursor->fragment->next_fragment) {
+    // No more data, report buffer as full
+    return true;
+  }
+
+  rmw_ertps_static_input_buffer_t * next_fragment =
+    reinterpret_cast<rmw_ertps_static_input_buffer_t *>(cursor->fragment->next_fragment->data);
+  uint8_t * data = &next_fragment->buffer[RMW_ERTPS_FRAGMENT_HEADROOM];
+  size_t size = next_fragment->fragment_length;
+
+  if (ub->offset < cursor->end_offset) {
+    // A primitive is split between fragments: move its first bytes into the headroom
+    size_t pending = cursor->end_offset - ub->offset;
+    if (pending > RMW_ERTPS_FRAGMENT_HEADROOM) {
+      return true;
+    }
+    data -= pending;
+    size += pending;
+    memcpy(data, ub->iterator, pending);
+  } else {
+    // Alignment padding may already have crossed the fragment boundary
+    size_t skip = ub->offset - cursor->end_offset;
+    if (skip > size) {
+      return true;
+    }
+    data += skip;
+    size -= skip;
+  }
+
+  ucdrEndianness endianness = ub->endianness;
+  cursor->fragment = next_fragment;
+  cursor->end_offset = ub->offset + size;
+  ucdr_init_buffer_origin(ub, data, size, ub->offset);
+  ub->endianness = endianness;
+  ucdr_set_on_full_buffer_callback(ub, on_full_input_fragment, cursor);
+
+  return false;
+}
+
+static bool deserialize_linear_buffer(
+  rmw_ertps_static_input_buffer_t * static_buffer,
+  const message_type_support_callbacks_t * functions,
+  size_t plain_size,
+  rmw_ertps_allocation_t * allocation,
+  void * ros_message)
+{
+  // Gather every fragment into the preallocated buffer
+  uint8_t * buffer = allocation->buffer;
+  memcpy(buffer, static_buffer->buffer, static_buffer->fragment_length);
+  size_t copied = static_buffer->fragment_length;
+
+  rmw_ertps_mempool_item_t * fragment_item = static_buffer->next_fragment;
+  while (fragment_item != NULL) {
+    rmw_ertps_static_input_buffer_t * fragment =
+      reinterpret_cast<rmw_ertps_static_input_buffer_t *>(fragment_item->data);
+    memcpy(
+      &buffer[copied], &fragment->buffer[RMW_ERTPS_FRAGMENT_HEADROOM],
+      fragment->fragment_length);
+    copied += fragment->fragment_length;
+    fragment_item = fragment->next_fragment;
+  }
+
+  if (plain_size > 0 && copied >= plain_size + 4 && 1 == buffer[1]) {
+    memcpy(ros_message, &buffer[4], plain_size);
+    return true;
+  }
+
+  ucdrBuffer temp_buffer;
+  ucdr_init_buffer(&temp_buffer, &buffer[4], copied - 4);
+
+  return functions->cdr_deserialize(&temp_buffer, ros_message);
+}
+
+bool rmw_ertps_deserialize_static_input_buffer(
+  rmw_ertps_static_input_buffer_t * static_buffer,
+  const message_type_support_callbacks_t * functions,
+  size_t plain_size,
+  rmw_ertps_allocation_t * allocation,
+  void * ros_message)
+{
+  if (NULL != static_buffer->next_fragment &&
+    NULL != allocation &&
+    allocation->size >= static_buffer->length)
+  {
+    return deserialize_linear_buffer(
+      static_buffer, functions, plain_size, allocation, ros_message);
+  }
+
+  if (plain_size > 0 &&
+    NULL == static_buffer->next_fragment &&
+    static_buffer->fragment_length >= plain_size + 4 &&
+    1 == static_buffer->buffer[1])
+  {
+    // Little endian CDR sample of a type whose CDR layout matches the in-memory one
+    memcpy(ros_message, &static_buffer->buffer[4], plain_size);
+    return true;
+  }
+
+  ucdrBuffer temp_buffer;
+  ucdr_init_buffer(
+    &temp_buffer,
+    &static_buffer->buffer[4],
+    static_buffer->fragment_length - 4);
+
+  rmw_ertps_fragment_cursor_t cursor;
+  if (NULL != static_buffer->next_fragment) {
+    cursor.fragment = static_buffer;
+    cursor.end_offset = static_buffer->fragment_length - 4;
+    ucdr_set_on_full_buffer_callback(&temp_buffer, on_full_input_fragment, &cursor);
+  }
+
+  return functions->cdr_deserialize(&temp_buffer, ros_message);
+}
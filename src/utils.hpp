@@ -49,6 +49,63 @@ int generate_service_topics(
 bool is_ertps_rmw_identifier_valid(
   const char * id);
 
+void rmw_ertps_guid_to_writer_guid(
+  const rtps::Guid_t & guid,
+  int8_t writer_guid[16]);
+
+void rmw_ertps_writer_guid_to_guid(
+  const int8_t writer_guid[16],
+  rtps::Guid_t & guid);
+
+void rmw_ertps_match_local_publisher(
+  rmw_ertps_publisher_t * publisher);
+
+void rmw_ertps_match_local_subscription(
+  rmw_ertps_subscription_t * subscription);
+
+rcutils_duration_value_t rmw_ertps_lifespan_nsec(
+  rmw_time_t lifespan);
+
+rtps::Reader * rmw_ertps_find_reply_reader(
+  const rmw_ertps_client_t * client,
+  const char * reply_topic,
+  const char * reply_type);
+
+void rmw_ertps_match_local_client(
+  rmw_ertps_client_t * client);
+
+void rmw_ertps_match_local_service(
+  rmw_ertps_service_t * service);
+
+size_t rmw_ertps_get_plain_message_size(
+  const rosidl_message_type_support_t * type_support);
+
+rmw_ertps_allocation_t * rmw_ertps_create_allocation(
+  const rosidl_message_type_support_t * type_support,
+  const rosidl_runtime_c__Sequence__bound * message_bounds);
+
+uint8_t * rmw_ertps_serialize_message(
+  const message_type_support_callbacks_t * functions,
+  const void * ros_message,
+  size_t plain_size,
+  uint8_t * static_buffer,
+  size_t static_buffer_size,
+  size_t * length);
+
+void rmw_ertps_release_output_buffer(
+  uint8_t * buffer,
+  const uint8_t * static_buffer);
+
+// Creates the lock of the serialization buffer shared by rmw_send_response calls
+bool rmw_ertps_init_response_buffer();
+
+bool rmw_ertps_deserialize_static_input_buffer(
+  rmw_ertps_static_input_buffer_t * static_buffer,
+  const message_type_support_callbacks_t * functions,
+  size_t plain_size,
+  rmw_ertps_allocation_t * allocation,
+  void * ros_message);
+
 #ifdef __cplusplus
 }
 #endif
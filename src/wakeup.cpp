@@ -0,0 +1,191 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./wakeup.hpp"
+
+#include <rmw/time.h>
+
+#ifdef RMW_ERTPS_WAKEUP_PTHREAD
+#include <time.h>
+#endif
+
+static bool is_infinite(
+  const rmw_time_t * timeout)
+{
+  return NULL == timeout || rmw_time_equal(*timeout, (rmw_time_t)RMW_DURATION_INFINITE);
+}
+
+#ifdef RMW_ERTPS_WAKEUP_PTHREAD
+
+bool rmw_ertps_wakeup_init(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  pthread_condattr_t attr;
+  if (0 != pthread_condattr_init(&attr)) {
+    return false;
+  }
+
+  bool ret = 0 == pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) &&
+    0 == pthread_cond_init(&wakeup->cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  if (ret && 0 != pthread_mutex_init(&wakeup->mutex, NULL)) {
+    pthread_cond_destroy(&wakeup->cond);
+    ret = false;
+  }
+
+  wakeup->signaled = false;
+  return ret;
+}
+
+void rmw_ertps_wakeup_fini(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  pthread_cond_destroy(&wakeup->cond);
+  pthread_mutex_destroy(&wakeup->mutex);
+}
+
+void rmw_ertps_wakeup_signal(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  pthread_mutex_lock(&wakeup->mutex);
+  if (!wakeup->signaled) {
+    wakeup->signaled = true;
+    pthread_cond_signal(&wakeup->cond);
+  }
+  pthread_mutex_unlock(&wakeup->mutex);
+}
+
+void rmw_ertps_wakeup_reset(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  pthread_mutex_lock(&wakeup->mutex);
+  wakeup->signaled = false;
+  pthread_mutex_unlock(&wakeup->mutex);
+}
+
+bool rmw_ertps_wakeup_wait(
+  rmw_ertps_wakeup_t * wakeup,
+  const rmw_time_t * timeout)
+{
+  const bool infinite = is_infinite(timeout);
+  const rmw_duration_t timeout_ns = infinite ? 0 : rmw_time_total_nsec(*timeout);
+
+  struct timespec deadline;
+  if (!infinite) {
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += static_cast<time_t>(timeout_ns / 1000000000LL);
+    deadline.tv_nsec += static_cast<long>(timeout_ns % 1000000000LL);  // NOLINT
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+  }
+
+  pthread_mutex_lock(&wakeup->mutex);
+  int rv = 0;
+  while (!wakeup->signaled && 0 == rv) {
+    if (infinite) {
+      rv = pthread_cond_wait(&wakeup->cond, &wakeup->mutex);
+    } else if (timeout_ns <= 0) {
+      break;
+    } else {
+      rv = pthread_cond_timedwait(&wakeup->cond, &wakeup->mutex, &deadline);
+    }
+  }
+
+  const bool signaled = wakeup->signaled;
+  wakeup->signaled = false;
+  pthread_mutex_unlock(&wakeup->mutex);
+
+  return signaled;
+}
+
+#else
+
+// The semaphore is only posted on the false to true transition of signaled, so
+// its count never exceeds one no matter how many samples arrive
+
+bool rmw_ertps_wakeup_init(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  wakeup->signaled = false;
+  return ERR_OK == sys_sem_new(&wakeup->sem, 0);
+}
+
+void rmw_ertps_wakeup_fini(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  sys_sem_free(&wakeup->sem);
+}
+
+void rmw_ertps_wakeup_signal(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+  SYS_ARCH_PROTECT(lev);
+  const bool post = !wakeup->signaled;
+  wakeup->signaled = true;
+  SYS_ARCH_UNPROTECT(lev);
+
+  if (post) {
+    sys_sem_signal(&wakeup->sem);
+  }
+}
+
+void rmw_ertps_wakeup_reset(
+  rmw_ertps_wakeup_t * wakeup)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+  SYS_ARCH_PROTECT(lev);
+  const bool pending = wakeup->signaled;
+  SYS_ARCH_UNPROTECT(lev);
+
+  // Already posted or about to be. lwIP waits forever on a zero timeout, so the
+  // shortest bounded wait is used. If the post is still on its way, signaled stays
+  // set and the next wait consumes it.
+  if (pending && SYS_ARCH_TIMEOUT != sys_arch_sem_wait(&wakeup->sem, 1)) {
+    SYS_ARCH_PROTECT(lev);
+    wakeup->signaled = false;
+    SYS_ARCH_UNPROTECT(lev);
+  }
+}
+
+bool rmw_ertps_wakeup_wait(
+  rmw_ertps_wakeup_t * wakeup,
+  const rmw_time_t * timeout)
+{
+  uint32_t timeout_ms = 0;  // lwIP waits forever on 0
+  if (!is_infinite(timeout)) {
+    const rmw_duration_t timeout_ns = rmw_time_total_nsec(*timeout);
+    if (timeout_ns <= 0) {
+      return false;
+    }
+    // Rounded up, so sub-millisecond waits neither block forever nor return early
+    timeout_ms = static_cast<uint32_t>((timeout_ns + 999999LL) / 1000000LL);
+  }
+
+  if (SYS_ARCH_TIMEOUT == sys_arch_sem_wait(&wakeup->sem, timeout_ms)) {
+    return false;
+  }
+
+  SYS_ARCH_DECL_PROTECT(lev);
+  SYS_ARCH_PROTECT(lev);
+  wakeup->signaled = false;
+  SYS_ARCH_UNPROTECT(lev);
+
+  return true;
+}
+
+#endif  // RMW_ERTPS_WAKEUP_PTHREAD
@@ -0,0 +1,72 @@
+// Copyright 2021 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WAKEUP_HPP_
+#define WAKEUP_HPP_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <rmw/types.h>
+
+#if defined(__linux__)
+// Linux hosts wait on a condition variable with a monotonic deadline, lwIP
+// semaphores only offer millisecond timeouts
+#define RMW_ERTPS_WAKEUP_PTHREAD
+#include <pthread.h>
+#else
+#include <lwip/sys.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Coalescing wakeup, any number of signals before a wait wake it only once
+typedef struct rmw_ertps_wakeup_t
+{
+#ifdef RMW_ERTPS_WAKEUP_PTHREAD
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#else
+  sys_sem_t sem;
+#endif
+  bool signaled;
+} rmw_ertps_wakeup_t;
+
+bool rmw_ertps_wakeup_init(
+  rmw_ertps_wakeup_t * wakeup);
+
+void rmw_ertps_wakeup_fini(
+  rmw_ertps_wakeup_t * wakeup);
+
+void rmw_ertps_wakeup_signal(
+  rmw_ertps_wakeup_t * wakeup);
+
+// Drops a pending signal, to be called before checking the state it announces
+void rmw_ertps_wakeup_reset(
+  rmw_ertps_wakeup_t * wakeup);
+
+// Blocks until signaled or timed out, NULL or infinite timeouts block forever
+// and zero timeouts return immediately. Returns false on timeout.
+bool rmw_ertps_wakeup_wait(
+  rmw_ertps_wakeup_t * wakeup,
+  const rmw_time_t * timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WAKEUP_HPP_